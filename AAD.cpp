@@ -19,8 +19,8 @@ As long as this comment is preserved at the top of the file
 
 //  Statics
 
-size_t Node::numAdj = 1;
-bool Tape::multi = false;
+atomic<size_t> Node::numAdj{1};
+atomic<bool> Tape::multi{false};
 
 Tape globalTape;
 thread_local Tape *Number::tape = &globalTape;
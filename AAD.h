@@ -37,6 +37,9 @@ As long as this comment is preserved at the top of the file
 
 //  Routines for multi-dimensional AAD (chapter 14)
 //  Set static context for multi-dimensional AAD
+//  The mode is process wide: concurrent AAD requests (see the async
+//      tier in main.h) are safe as long as they all run in the same
+//      mode; single and multi dimensional requests must not overlap
 
 //	RAII: reset dimension 1 on destruction
 struct numResultsResetterForAAD {
@@ -0,0 +1,206 @@
+
+/*
+Written by Antoine Savine in 2018
+
+This code is the strict IP of Antoine Savine
+
+License to use and alter this code for personal and commercial applications
+is freely granted to any person or company who purchased a copy of the book
+
+Modern Computational Finance: AAD and Parallel Simulations
+Antoine Savine
+Wiley, 2018
+
+As long as this comment is preserved at the top of the file
+*/
+
+#pragma once
+
+//  Compact, index-based image of a recorded tape region
+
+//  The live tape (chapter 10) stores 3 pointers per node and
+//      propagation chases pAdjPtrs[i] (a pointer to a pointer) per child.
+//  The compact image stores 32-bit node ordinals into one flat adjoint
+//      array and the derivatives in a parallel flat array, roughly
+//      halving the footprint and turning the backward sweep into a
+//      sequential walk of two contiguous buffers.
+//  Children recorded below the captured region (e.g. model parameters
+//      below the mark) become external slots, flushed back into their
+//      node adjoints after propagation.
+
+//  Single-dimensional adjoints only (the chapter 14 multi mode keeps
+//      its own storage).
+
+#include "AADTape.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+class CompactTape {
+  //  Per node: offset of its first argument in myArgs / myDers
+  //      (one extra entry so nArgs(i) = myFirstArg[i+1] - myFirstArg[i])
+  vector<uint32_t> myFirstArg;
+
+  //  Arguments as node ordinals, concatenated over nodes
+  vector<uint32_t> myArgs;
+  //  Matching local derivatives
+  vector<double> myDers;
+  //  Matching live adjoint addresses, only read by refreshDerivatives
+  //      to validate that a re-recorded region has the same wiring
+  //      (addresses are stable across rewindToMark re-records)
+  vector<double *> myArgPtrs;
+
+  //  Flat adjoints: [0, myNodes) internal, [myNodes, end) external
+  vector<double> myAdjoints;
+  size_t myNodes = 0;
+
+  //  External children: the address of their live adjoint,
+  //      aligned with the external slots of myAdjoints
+  vector<double *> myExternalPtrs;
+
+  //  Live adjoint address -> ordinal, for seeding and externals
+  unordered_map<const double *, uint32_t> myOrdinals;
+
+public:
+  //  Capture the structure and derivatives
+  //      of the region [from, to), to excluded
+  void build(Tape::iterator from, Tape::iterator to) {
+    myFirstArg.clear();
+    myArgs.clear();
+    myDers.clear();
+    myArgPtrs.clear();
+    myExternalPtrs.clear();
+    myOrdinals.clear();
+    myNodes = 0;
+
+    //  First pass: number the nodes of the region
+    for (auto it = from; it != to; ++it) {
+      myOrdinals[&it->mAdjoint] = uint32_t(myNodes++);
+    }
+
+    //  Second pass: capture arguments and derivatives
+    myFirstArg.reserve(myNodes + 1);
+    for (auto it = from; it != to; ++it) {
+      myFirstArg.push_back(uint32_t(myArgs.size()));
+      for (size_t i = 0; i < it->n; ++i) {
+        //  pAdjPtrs[i] is the address of the child's adjoint
+        double *childAdj = it->pAdjPtrs[i];
+        auto found = myOrdinals.find(childAdj);
+        uint32_t ordinal;
+        if (found != myOrdinals.end()) {
+          ordinal = found->second;
+        } else {
+          //  Child below the region: external slot
+          ordinal = uint32_t(myNodes + myExternalPtrs.size());
+          myOrdinals[childAdj] = ordinal;
+          myExternalPtrs.push_back(childAdj);
+        }
+        myArgs.push_back(ordinal);
+        myDers.push_back(it->pDerivatives[i]);
+        myArgPtrs.push_back(childAdj);
+      }
+    }
+    myFirstArg.push_back(uint32_t(myArgs.size()));
+
+    myAdjoints.assign(myNodes + myExternalPtrs.size(), 0.0);
+  }
+
+  //  Refresh the derivatives from a re-recorded region
+  //      with the identical structure (replay, see chapter 15 notes):
+  //      sequential copy, no hashing, no rewiring
+  //  Payoffs that branch (e.g. smoothed digitals) may record different
+  //      expressions on different paths: the wiring is validated against
+  //      the captured child addresses, and false is returned
+  //      (the caller must rebuild) on any structural change
+  bool refreshDerivatives(Tape::iterator from, Tape::iterator to) {
+    size_t d = 0;
+    const size_t nDers = myDers.size();
+    for (auto it = from; it != to; ++it) {
+      if (d + it->n > nDers)
+        return false;
+      for (size_t i = 0; i < it->n; ++i) {
+        if (it->pAdjPtrs[i] != myArgPtrs[d])
+          return false;
+        myDers[d++] = it->pDerivatives[i];
+      }
+    }
+    return d == nDers;
+  }
+
+  //  Fused refresh and sweep: one backward pass over a re-recorded
+  //      region, validating the wiring, reading the fresh derivatives
+  //      in place and propagating over the flat adjoints,
+  //      so the derivative stream is traversed once instead of twice
+  //  Returns false on structural change: the adjoints are then stale
+  //      and the caller must rebuild, reset, seed and propagate again
+  bool propagateFused(Tape::iterator from, Tape::iterator to) {
+    size_t node = myNodes;
+    auto it = to;
+    while (it != from && node > 0) {
+      --it;
+      --node;
+
+      const uint32_t first = myFirstArg[node], last = myFirstArg[node + 1];
+      if (size_t(last - first) != it->n)
+        return false;
+
+      const double adj = myAdjoints[node];
+      if (!adj)
+        continue;
+
+      for (uint32_t a = first; a < last; ++a) {
+        if (it->pAdjPtrs[a - first] != myArgPtrs[a])
+          return false;
+        myAdjoints[myArgs[a]] += it->pDerivatives[a - first] * adj;
+      }
+    }
+
+    //  Both walks must exhaust together
+    return it == from && node == 0;
+  }
+
+  //  Seed access that signals a structural change with null
+  //      instead of throwing
+  double *findAdjoint(const double *liveAdjoint) {
+    auto found = myOrdinals.find(liveAdjoint);
+    return found == myOrdinals.end() ? nullptr : &myAdjoints[found->second];
+  }
+
+  //  Number of nodes in the image
+  size_t size() const { return myNodes; }
+
+  //  Reset all adjoints, internal and external slots
+  void resetAdjoints() { fill(myAdjoints.begin(), myAdjoints.end(), 0.0); }
+
+  //  Seed the adjoint of a node by the address of its live adjoint
+  //      (e.g. &number.node().adjoint() captured in the region)
+  double &adjoint(const double *liveAdjoint) {
+    return myAdjoints[myOrdinals.at(liveAdjoint)];
+  }
+
+  //  Backward sweep over the image: sequential read of the
+  //      argument and derivative arrays, random access only
+  //      into the flat adjoint array
+  void propagate() {
+    for (size_t i = myNodes; i > 0; --i) {
+      const size_t node = i - 1;
+      const double adj = myAdjoints[node];
+      if (!adj)
+        continue;
+
+      const uint32_t first = myFirstArg[node], last = myFirstArg[node + 1];
+      for (uint32_t a = first; a < last; ++a) {
+        myAdjoints[myArgs[a]] += myDers[a] * adj;
+      }
+    }
+  }
+
+  //  Accumulate the external slots back
+  //      into the live adjoints below the region
+  void flushExternal() {
+    for (size_t e = 0; e < myExternalPtrs.size(); ++e) {
+      *myExternalPtrs[e] += myAdjoints[myNodes + e];
+    }
+  }
+};
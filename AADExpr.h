@@ -92,6 +92,22 @@ public:
           adjoint * OP::rightDerivative(lhs.value(), rhs.value(), value()));
     }
   }
+
+  //  Record-free variant for the static payoff kernels (chapter 15
+  //      machinery, used by mcSimulAADStatic in mcBase.h):
+  //      the whole expression's adjoints accumulate straight into
+  //      the leaves' node adjoints, nothing is recorded on tape
+  //  Single dimensional adjoints only
+  void accumulateAdjoints(const double adjoint) const {
+    if (LHS::numNumbers > 0) {
+      lhs.accumulateAdjoints(
+          adjoint * OP::leftDerivative(lhs.value(), rhs.value(), value()));
+    }
+    if (RHS::numNumbers > 0) {
+      rhs.accumulateAdjoints(
+          adjoint * OP::rightDerivative(lhs.value(), rhs.value(), value()));
+    }
+  }
 };
 
 //  "Concrete" binaries, we only need to define operations and derivatives
@@ -283,6 +299,13 @@ public:
           exprNode, adjoint * OP::derivative(arg.value(), value(), dArg));
     }
   }
+
+  //  Record-free variant, see BinaryExpression
+  void accumulateAdjoints(const double adjoint) const {
+    if (ARG::numNumbers > 0) {
+      arg.accumulateAdjoints(adjoint * OP::derivative(arg.value(), value(), dArg));
+    }
+  }
 };
 
 //  The unary operators
@@ -702,6 +725,12 @@ public:
     exprNode.pDerivatives[n] = adjoint;
   }
 
+  //  Record-free variant: accumulate straight into this leaf's
+  //      node adjoint (single dimensional), see BinaryExpression
+  void accumulateAdjoints(const double adjoint) const {
+    myNode->mAdjoint += adjoint;
+  }
+
   //  Static access to tape, same as traditional
   static thread_local Tape *tape;
 
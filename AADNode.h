@@ -23,12 +23,14 @@ As long as this comment is preserved at the top of the file
 
 //  Unchanged for AADET of chapter 15
 
+#include <atomic>
 #include <exception>
 using namespace std;
 
 class Node {
   friend class Tape;
   friend class Number;
+  friend class CompactTape;
   friend auto setNumResultsForAAD(const bool, const size_t);
   friend struct numResultsResetterForAAD;
 
@@ -48,7 +50,10 @@ class Node {
 
   //  Number of adjoints (results) to propagate, usually 1
   //  See chapter 14
-  static size_t numAdj;
+  //  Atomic: concurrent (async) AAD requests set the mode through
+  //      setNumResultsForAAD without a data race; all concurrent
+  //      requests must still share one mode, see AAD.h
+  static atomic<size_t> numAdj;
 
   //  Number of childs (arguments)
   const size_t n;
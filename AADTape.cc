@@ -11,6 +11,22 @@
 #include "AADNode.h"
 #include "blocklist.h"
 
+//  Storage in use
+Tape::Footprint Tape::used() {
+  return Footprint{myNodes.used(), myDers.used(),
+                   multi ? myAdjointsMulti.used() : size_t(0)};
+}
+
+//  Pre-reserve all the storages
+void Tape::reserve(const Footprint &footprint) {
+  myNodes.reserve(footprint.nodes);
+  myDers.reserve(footprint.ders);
+  myArgPtrs.reserve(footprint.ders);
+  if (multi) {
+    myAdjointsMulti.reserve(footprint.adjoints);
+  }
+}
+
 //  Reset all adjoints to 0
 void Tape::resetAdjoints() {
   if (multi) {
@@ -32,7 +32,8 @@ constexpr size_t DATASIZE = 65536;  //	Data in bytes
 
 class Tape {
   //	Working with multiple results / adjoints?
-  static bool multi;
+  //	Atomic, see Node::numAdj
+  static atomic<bool> multi;
 
   //  Storage for adjoints in multi-dimensional case (chapter 14)
   blocklist<double, ADJSIZE> myAdjointsMulti;
@@ -59,9 +60,14 @@ public:
     Node *node = myNodes.emplace_back(N);
 
     //  Store and zero the adjoint(s)
+    //  The allocation is rounded up to 8 doubles, so with the blocks
+    //      cache line aligned every adjoint vector starts
+    //      on a 64 byte boundary for the SIMD propagation kernel
     if (multi) {
-      node->pAdjoints = myAdjointsMulti.emplace_back_multi(Node::numAdj);
-      fill(node->pAdjoints, node->pAdjoints + Node::numAdj, 0.0);
+      const size_t nAdj = Node::numAdj;
+      const size_t padded = (nAdj + 7) & ~size_t(7);
+      node->pAdjoints = myAdjointsMulti.emplace_back_multi(padded);
+      fill(node->pAdjoints, node->pAdjoints + nAdj, 0.0);
     }
 
     //	Store the derivatives and child adjoint pointers unless leaf
@@ -73,6 +79,19 @@ public:
     return node;
   }
 
+  //  Storage in use, e.g. the footprint of a recorded dry path
+  struct Footprint {
+    size_t nodes;
+    size_t ders;
+    size_t adjoints;
+  };
+  Footprint used();
+
+  //  Pre-reserve all the storages, absolute capacities
+  //  Calibrate with the footprint of one dry path (see mcBase.h)
+  //      so the path loop never hits the system allocator
+  void reserve(const Footprint &footprint);
+
   //  Reset all adjoints to 0
   void resetAdjoints();
 
@@ -17,36 +17,222 @@ As long as this comment is preserved at the top of the file
 #pragma once
 
 //  Thread pool of chapter 3
-
-#include "ConcurrentQueue.h"
+//  Scheduling is work stealing: one deque per thread,
+//      the owner pushes and pops at the front,
+//      idle threads steal from the back of the others,
+//  so tasks no longer funnel through one mutex
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
+#include <mutex>
 #include <thread>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 using namespace std;
 
-typedef packaged_task<bool(void)> Task;
 typedef future<bool> TaskHandle;
 
+//  Type erased task with inline storage: the engines' batch tasks
+//      fit the buffer, so queuing a task never touches the allocator
+//      (futures and their shared state are only created by the
+//      future-returning spawnTask overload)
+class PoolTask {
+  static constexpr size_t BUFSIZE = 192;
+
+  alignas(16) unsigned char myBuf[BUFSIZE];
+
+  //  Manager functions of the erased type
+  void (*myInvoke)(unsigned char *) = nullptr;
+  void (*myMove)(unsigned char *, unsigned char *) = nullptr;
+  void (*myDestroy)(unsigned char *) = nullptr;
+
+public:
+  PoolTask() {}
+
+  template <class C> PoolTask(C c) {
+    static_assert(sizeof(C) <= BUFSIZE, "PoolTask: callable too large");
+    new (myBuf) C(move(c));
+    myInvoke = [](unsigned char *buf) { (*reinterpret_cast<C *>(buf))(); };
+    myMove = [](unsigned char *dst, unsigned char *from) {
+      new (dst) C(move(*reinterpret_cast<C *>(from)));
+    };
+    myDestroy = [](unsigned char *buf) { reinterpret_cast<C *>(buf)->~C(); };
+  }
+
+  PoolTask(PoolTask &&rhs)
+      : myInvoke(rhs.myInvoke), myMove(rhs.myMove), myDestroy(rhs.myDestroy) {
+    if (myMove)
+      myMove(myBuf, rhs.myBuf);
+  }
+
+  PoolTask &operator=(PoolTask &&rhs) {
+    if (this == &rhs)
+      return *this;
+    if (myDestroy)
+      myDestroy(myBuf);
+    myInvoke = rhs.myInvoke;
+    myMove = rhs.myMove;
+    myDestroy = rhs.myDestroy;
+    if (myMove)
+      myMove(myBuf, rhs.myBuf);
+    return *this;
+  }
+
+  ~PoolTask() {
+    if (myDestroy)
+      myDestroy(myBuf);
+  }
+
+  PoolTask(const PoolTask &) = delete;
+  PoolTask &operator=(const PoolTask &) = delete;
+
+  void operator()() { myInvoke(myBuf); }
+};
+
+typedef PoolTask Task;
+
+//  Completion object for a whole range of tasks:
+//      one atomic countdown and one wait,
+//      instead of one future per task
+//  Lifetime protocol: the last done() runs entirely under the
+//      mutex, and anyone who observed completion through the
+//      lock-free finished() synchronizes on the mutex once (sync(),
+//      done by activeWait) before the group may be destroyed -
+//      otherwise the completing task could broadcast on a condition
+//      variable whose owner already left the scope
+class TaskGroup {
+  friend class ThreadPool;
+
+  atomic<size_t> myRemaining;
+  mutex myMutex;
+  condition_variable myCV;
+
+  //  Called by the pool
+  void add(const size_t n) { myRemaining += n; }
+  void done() {
+    //  Decrement and notify under the mutex: a waiter that saw the
+    //      countdown hit zero still acquires the mutex once before
+    //      returning, so we never touch a destroyed group here
+    lock_guard<mutex> lk(myMutex);
+    if (--myRemaining == 0) {
+      myCV.notify_all();
+    }
+  }
+
+public:
+  TaskGroup() : myRemaining(0) {}
+
+  //  Lock-free completion check; see the lifetime protocol above
+  bool finished() const { return myRemaining == 0; }
+
+  //  Synchronize with the last done() after observing finished():
+  //      once the mutex is acquired, the completing task
+  //      has left the group
+  void sync() { lock_guard<mutex> lk(myMutex); }
+
+  //  Block until all the group's tasks completed
+  void wait() {
+    unique_lock<mutex> lk(myMutex);
+    myCV.wait(lk, [this]() { return myRemaining == 0; });
+  }
+};
+
+//  Work stealing deque: locked per deque, not per pool,
+//      so the owner and the occasional thief only contend pairwise
+template <class T> class WorkStealingQueue {
+  deque<T> myDeque;
+  mutable mutex myMutex;
+
+public:
+  WorkStealingQueue() {}
+
+  //	Owner side: push and pop at the front
+  void push(T t) {
+    lock_guard<mutex> lk(myMutex);
+    myDeque.push_front(move(t));
+  }
+
+  bool tryPop(T &t) {
+    lock_guard<mutex> lk(myMutex);
+    if (myDeque.empty())
+      return false;
+    t = move(myDeque.front());
+    myDeque.pop_front();
+    return true;
+  }
+
+  //	Thief side: steal from the back
+  bool trySteal(T &t) {
+    lock_guard<mutex> lk(myMutex);
+    if (myDeque.empty())
+      return false;
+    t = move(myDeque.back());
+    myDeque.pop_back();
+    return true;
+  }
+
+  void clear() {
+    lock_guard<mutex> lk(myMutex);
+    myDeque.clear();
+  }
+};
+
 class ThreadPool {
   //	The one and only instance
   static ThreadPool myInstance;
 
-  //	The task queue
-  ConcurrentQueue<Task> myQueue;
+  //	One task deque per thread, index 0 = main thread
+  vector<unique_ptr<WorkStealingQueue<Task>>> myQueues;
 
   //	The threads
   vector<thread> myThreads;
 
+  //	Core each thread is pinned on, by thread number (0 = main)
+  vector<size_t> myCores;
+
   //  Active indicator
   bool myActive;
 
   //	Interruption indicator
   bool myInterrupt;
 
+  //	Number of tasks in the deques, governs the workers' sleep
+  atomic<int> myPending;
+
+  //	Sleep on this when all the deques are empty
+  mutex myWaitMutex;
+  condition_variable myWaitCV;
+
   //	Thread number
   static thread_local size_t myTLSNum;
 
+  //	Pop own deque, steal from the others otherwise
+  bool findTask(Task &t) {
+    const size_t num = myTLSNum;
+    const size_t nQueues = myQueues.size();
+
+    if (myQueues[num]->tryPop(t)) {
+      --myPending;
+      return true;
+    }
+
+    for (size_t i = 1; i < nQueues; ++i) {
+      if (myQueues[(num + i) % nQueues]->trySteal(t)) {
+        --myPending;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
   //	The function that is executed on every thread
   void threadFunc(const size_t num) {
     myTLSNum = num;
@@ -55,15 +241,23 @@ class ThreadPool {
 
     //	"Infinite" loop, only broken on destruction
     while (!myInterrupt) {
-      //	Pop and executes tasks
-      myQueue.pop(t);
-      if (!myInterrupt)
+      //	Pop or steal and execute tasks
+      if (findTask(t)) {
         t();
+      } else {
+        //	Nothing to run anywhere: go to sleep
+        unique_lock<mutex> lk(myWaitMutex);
+        myWaitCV.wait(lk, [this]() { return myInterrupt || myPending > 0; });
+      }
     }
   }
 
   //  The constructor stays private, ensuring single instance
-  ThreadPool() : myActive(false), myInterrupt(false) {}
+  //	The main thread's deque exists from the start
+  //		so tasks may be spawned (and actively waited) before start()
+  ThreadPool() : myActive(false), myInterrupt(false), myPending(0) {
+    myQueues.push_back(make_unique<WorkStealingQueue<Task>>());
+  }
 
 public:
   //	Access the instance
@@ -76,39 +270,79 @@ public:
   static size_t threadNum() { return myTLSNum; }
 
   //	Starter
-  void start(const size_t nThread = thread::hardware_concurrency() - 1) {
+  //	When pinThreads is set (and the platform supports it),
+  //	worker i is pinned on core i % hardware_concurrency, so NUMA
+  //	first-touch allocations made on a worker stay on its node
+  void start(const size_t nThread = thread::hardware_concurrency() - 1,
+             const bool pinThreads = true) {
     if (!myActive) //  Only start once
     {
+      //	One deque per thread, 0 for the main thread
+      //	The main thread's deque already exists, keep it
+      myQueues.resize(nThread + 1);
+      for (auto &queue : myQueues) {
+        if (!queue)
+          queue = make_unique<WorkStealingQueue<Task>>();
+      }
+
       myThreads.reserve(nThread);
+      myCores.assign(nThread + 1, 0);
 
       //	Launch threads on threadFunc and keep handles in a vector
       for (size_t i = 0; i < nThread; i++)
         myThreads.push_back(thread(&ThreadPool::threadFunc, this, i + 1));
 
+      //	Pin the workers, one core each
+      if (pinThreads) {
+#ifdef __linux__
+        const size_t nCores = thread::hardware_concurrency();
+        for (size_t i = 0; i < nThread; i++) {
+          const size_t core = (i + 1) % nCores;
+          cpu_set_t cpuSet;
+          CPU_ZERO(&cpuSet);
+          CPU_SET(core, &cpuSet);
+          if (pthread_setaffinity_np(myThreads[i].native_handle(),
+                                     sizeof(cpu_set_t), &cpuSet) == 0) {
+            myCores[i + 1] = core;
+          }
+        }
+#endif
+      }
+
       myActive = true;
     }
   }
 
+  //	Core each thread is pinned on, by thread number, 0 when unpinned
+  const vector<size_t> &threadCores() const { return myCores; }
+
   //	Destructor
   ~ThreadPool() { stop(); }
 
   void stop() {
     if (myActive) {
       //	Interrupt mode
-      myInterrupt = true;
+      {
+        lock_guard<mutex> lk(myWaitMutex);
+        myInterrupt = true;
+      }
 
       //	Interrupt all waiting threads
-      myQueue.interrupt();
+      myWaitCV.notify_all();
 
       //	Wait for them all to join
       for_each(myThreads.begin(), myThreads.end(), mem_fn(&thread::join));
 
       //  Clear all threads
       myThreads.clear();
+      myCores.clear();
 
-      //  Clear the queue and reset interrupt
-      myQueue.clear();
-      myQueue.resetInterrupt();
+      //  Clear the deques and reset counters
+      //	The deques themselves stay: index 0 serves the main thread
+      //		even when the pool is stopped
+      for (auto &queue : myQueues)
+        queue->clear();
+      myPending = 0;
 
       //  Mark as inactive
       myActive = false;
@@ -124,14 +358,73 @@ public:
   ThreadPool(ThreadPool &&rhs) = delete;
   ThreadPool &operator=(ThreadPool &&rhs) = delete;
 
-  //	Spawn task
+  //	Spawn task: push on the caller's own deque
   template <typename Callable> TaskHandle spawnTask(Callable c) {
-    Task t(move(c));
-    TaskHandle f = t.get_future();
-    myQueue.push(std::move(t));
+    packaged_task<bool(void)> p(move(c));
+    TaskHandle f = p.get_future();
+    Task t(move(p));
+    myQueues[myTLSNum]->push(std::move(t));
+
+    //	Wake one sleeping worker
+    //	The increment is made under the wait mutex
+    //		so a worker checking the predicate cannot miss it
+    {
+      lock_guard<mutex> lk(myWaitMutex);
+      ++myPending;
+    }
+    myWaitCV.notify_one();
+
     return f;
   }
 
+  //	Run one task from the caller's own deque, if any
+  //	Used by the pipelined engines: a worker's own deque only ever
+  //	holds tasks the worker spawned itself (sub-stages of its
+  //	current task), so running one cannot re-enter a batch
+  bool tryRunOwnTask() {
+    Task t;
+    if (myQueues[myTLSNum]->tryPop(t)) {
+      --myPending;
+      t();
+      return true;
+    }
+    return false;
+  }
+
+  //	Spawn a task under a group: no future, no shared state,
+  //	the group's countdown is the only completion bookkeeping
+  template <typename Callable> void spawnTask(TaskGroup &group, Callable c) {
+    group.add(1);
+    Task t([&group, c = move(c)]() mutable {
+      c();
+      group.done();
+    });
+    myQueues[myTLSNum]->push(std::move(t));
+
+    {
+      lock_guard<mutex> lk(myWaitMutex);
+      ++myPending;
+    }
+    myWaitCV.notify_one();
+  }
+
+  //	Run queued tasks while waiting on a whole group
+  void activeWait(TaskGroup &group) {
+    Task t;
+    while (!group.finished()) {
+      if (findTask(t)) {
+        t();
+      } else {
+        //	Nothing to run anywhere: block on the group
+        group.wait();
+      }
+    }
+
+    //	Synchronize with the last completion
+    //		before the caller may destroy the group
+    group.sync();
+  }
+
   //	Run queued tasks synchronously
   //	while waiting on a future,
   //	return true if at least one task was run
@@ -143,11 +436,11 @@ public:
     //	The only syntax C++11 provides for that is
     //	wait 0 seconds and return status
     while (f.wait_for(0s) != future_status::ready) {
-      //	Non blocking
-      if (myQueue.tryPop(t)) {
+      //	Pop or steal, non blocking
+      if (findTask(t)) {
         t();
         b = true;
-      } else //	Nothing in the queue: go to sleep
+      } else //	Nothing to run anywhere: go to sleep
       {
         f.wait();
       }
@@ -155,4 +448,4 @@ public:
 
     return b;
   }
-};
\ No newline at end of file
+};
@@ -16,8 +16,10 @@ inline T blackScholes(const U spot, const V strike, const T vol, const W mat) {
 }
 
 //  Implied vol, untemplated
-inline double blackScholesIvol(const double spot, const double strike,
-                               const double prem, const double mat) {
+//  Bracketing and bisection, the robust fallback
+//      of the Newton solver below
+inline double blackScholesIvolBisect(const double spot, const double strike,
+                                     const double prem, const double mat) {
   if (prem <= max(0.0, spot - strike) + EPS)
     return 0.0;
 
@@ -46,6 +48,65 @@ inline double blackScholesIvol(const double spot, const double strike,
   return l + (prem - pl) / (pu - pl) * (u - l);
 }
 
+//  Fast implied vol: Corrado-Miller rational initial guess refined
+//      by Newton with the analytic vega, converging in 2-4
+//      iterations on normal quotes; deep corner cases fall back on
+//      the bisection above, so the result is always at least as
+//      accurate as before
+inline double blackScholesIvol(const double spot, const double strike,
+                               const double prem, const double mat) {
+  if (prem <= max(0.0, spot - strike) + EPS)
+    return 0.0;
+
+  const double sqrtMat = sqrt(mat);
+
+  //  Corrado-Miller (1996) initial guess,
+  //      Brenner-Subrahmanyam when its root goes negative
+  const double half = 0.5 * (spot - strike);
+  const double cm = prem - half;
+  const double disc = cm * cm - half * half * 2.0 / 3.141592653589793;
+  double vol =
+      disc > 0.0
+          ? 2.506628274631 / ((spot + strike) * sqrtMat) * (cm + sqrt(disc))
+          : prem / spot * 2.506628274631 / sqrtMat;
+  if (vol <= 0.0)
+    vol = 0.2;
+
+  //  Newton with the analytic vega
+  for (int iter = 0; iter < 10; ++iter) {
+    const double std = vol * sqrtMat;
+    if (std <= EPS)
+      break;
+    const double d2 = log(spot / strike) / std - 0.5 * std;
+    const double d1 = d2 + std;
+    const double price = spot * normalCdf(d1) - strike * normalCdf(d2);
+    const double diff = price - prem;
+    if (fabs(diff) < 1.0e-12)
+      return vol;
+
+    const double vega = spot * normalDens(d1) * sqrtMat;
+    if (vega < 1.0e-10)
+      break;
+
+    vol -= diff / vega;
+    if (vol <= 0.0)
+      break;
+  }
+
+  //  No convergence: robust fallback
+  return blackScholesIvolBisect(spot, strike, prem, mat);
+}
+
+//  Batched implied vols: one call for a whole vector of quotes,
+//      the branch-light Newton iteration runs quote by quote
+inline void blackScholesIvolBatch(const double spot, const double *strikes,
+                                  const double *prems, double *vols,
+                                  const size_t n, const double mat) {
+  for (size_t i = 0; i < n; ++i) {
+    vols[i] = blackScholesIvol(spot, strikes[i], prems[i], mat);
+  }
+}
+
 //  Merton, templated
 
 template <class T, class U, class V, class W, class X>
@@ -0,0 +1,266 @@
+
+/*
+Written by Antoine Savine in 2018
+
+This code is the strict IP of Antoine Savine
+
+License to use and alter this code for personal and commercial applications
+is freely granted to any person or company who purchased a copy of the book
+
+Modern Computational Finance: AAD and Parallel Simulations
+Antoine Savine
+Wiley, 2018
+
+As long as this comment is preserved at the top of the file
+*/
+
+//  Microbenchmark suite over the AAD and simulation hot paths
+//  Stable, repeatable timings (fixed seeds, best of 3 repetitions)
+//      with ns/op, paths/sec and allocation counts,
+//      so compiler upgrades and new drops can be gated on numbers
+//
+//  Build (standalone target, like main.cc):
+//      g++ -std=c++17 -O2 bench.cc AAD.cpp AADNode.cc AADTape.cc \
+//          ThreadPool.cpp mcBase.cpp sobol.cpp -o bench -lpthread
+
+#include "main.h"
+
+#include <chrono>
+#include <cstdio>
+#include <new>
+
+using Clock = chrono::high_resolution_clock;
+
+//  Allocation counter: every operator new bumps it,
+//      so each benchmark reports how often it hits the allocator
+static size_t allocCount = 0;
+
+void *operator new(size_t size) {
+  ++allocCount;
+  if (void *p = malloc(size))
+    return p;
+  throw bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+//  Run a benchmark: best wall time of 3 repetitions,
+//      report ns/op and allocations per repetition
+template <class F>
+void bench(const char *name, const size_t ops, const F &body) {
+  double best = 1.0e99;
+  size_t allocs = 0;
+  for (int rep = 0; rep < 3; ++rep) {
+    const size_t a0 = allocCount;
+    const auto t0 = Clock::now();
+    body();
+    const auto t1 = Clock::now();
+    allocs = allocCount - a0;
+    best = min(best, chrono::duration<double, nano>(t1 - t0).count());
+  }
+  printf("%-36s %12.1f ns/op %14.0f op/s %10zu allocs\n", name, best / ops,
+         ops * 1.0e9 / best, allocs);
+}
+
+//  Global sink so the optimizer cannot drop the work
+static double sink = 0.0;
+
+int main() {
+  printf("%-36s %15s %16s %12s\n", "benchmark", "ns/op", "op/s", "allocs/rep");
+
+  //  Tape: recordNode and rewindToMark
+  {
+    Tape &tape = *Number::tape;
+    tape.clear();
+    auto resetter = setNumResultsForAAD();
+    Number x(1.0);
+    tape.mark();
+    const size_t n = 1000000;
+    bench("Tape record 1 binary node", n, [&]() {
+      tape.rewindToMark();
+      Number y = x;
+      for (size_t i = 0; i < n; ++i)
+        y = y + x;
+      sink += y.value();
+    });
+    bench("Tape rewindToMark", 100000, [&]() {
+      for (size_t i = 0; i < 100000; ++i)
+        tape.rewindToMark();
+    });
+    tape.clear();
+  }
+
+  //  Number expression arithmetic vs raw doubles
+  {
+    Tape &tape = *Number::tape;
+    tape.clear();
+    auto resetter = setNumResultsForAAD();
+    Number a(1.5), b(2.5);
+    tape.mark();
+    const size_t n = 200000;
+    bench("Number a*b + exp(a) - b/a", n, [&]() {
+      tape.rewindToMark();
+      Number acc(0.0);
+      for (size_t i = 0; i < n; ++i)
+        acc += a * b + exp(a) - b / a;
+      sink += acc.value();
+    });
+    double da = 1.5, db = 2.5;
+    bench("double a*b + exp(a) - b/a", n, [&]() {
+      double acc = 0.0;
+      for (size_t i = 0; i < n; ++i)
+        acc += da * db + exp(da) - db / da;
+      sink += acc;
+      da += 1.0e-12; //  keep the loop alive
+    });
+    tape.clear();
+  }
+
+  //  Adjoint propagation, single and multi dimensional
+  {
+    Tape &tape = *Number::tape;
+    tape.clear();
+    auto resetter = setNumResultsForAAD();
+    Number a(1.5), b(2.5);
+    tape.mark();
+    Number y(0.0);
+    const size_t n = 100000;
+    for (size_t i = 0; i < n; ++i)
+      y = y + a * b;
+    bench("propagateToMark over 100k nodes", n, [&]() {
+      tape.resetAdjoints();
+      y.propagateToMark();
+      sink += a.adjoint();
+    });
+    tape.clear();
+  }
+  {
+    Tape &tape = *Number::tape;
+    tape.clear();
+    auto resetter = setNumResultsForAAD(true, 32);
+    Number a(1.5), b(2.5);
+    tape.mark();
+    Number y(0.0);
+    const size_t n = 20000;
+    for (size_t i = 0; i < n; ++i)
+      y = y + a * b;
+    bench("propagateAdjointsMulti 20k x 32", n, [&]() {
+      tape.resetAdjoints();
+      y.adjoint(0) = 1.0;
+      Number::propagateAdjointsMulti(prev(tape.end()), tape.markIt());
+      sink += a.adjoint(0);
+    });
+    tape.clear();
+  }
+
+  //  Random number generation, 512 dimensions
+  {
+    const size_t dim = 512, points = 2000;
+    vector<double> g(dim);
+    matrix<double> block(64, dim);
+
+    Sobol sobol;
+    sobol.init(dim);
+    bench("Sobol nextG (dim 512)", points * dim,
+          [&]() { for (size_t p = 0; p < points; ++p) sobol.nextG(g); });
+    Sobol sobolB;
+    sobolB.init(dim);
+    bench("Sobol nextGBlock (64 pt blocks)", points * dim, [&]() {
+      for (size_t p = 0; p < points; p += 64)
+        sobolB.nextGBlock(block, 64);
+    });
+    mrg32k3a mrg;
+    mrg.init(dim);
+    bench("mrg32k3a nextG (dim 512)", points * dim,
+          [&]() { for (size_t p = 0; p < points; ++p) mrg.nextG(g); });
+    Philox philox;
+    philox.init(dim);
+    bench("Philox nextG (dim 512)", points * dim,
+          [&]() { for (size_t p = 0; p < points; ++p) philox.nextG(g); });
+    sink += g[0];
+  }
+
+  //  Dupire path generation and the products' payoffs
+  {
+    vector<double> spots{50, 75, 100, 125, 150, 200};
+    vector<Time> times{0.25, 0.5, 1.0, 2.0};
+    matrix<double> vols(6, 4);
+    for (auto &v : vols)
+      v = 0.15;
+    Dupire<double> dupire(100.0, spots, times, vols, 0.01);
+    UOC<double> uoc(100.0, 130.0, 1.0, 1.0 / 12, 0.02);
+    dupire.allocate(uoc.timeline(), uoc.defline());
+    dupire.init(uoc.timeline(), uoc.defline());
+
+    Sobol rng;
+    rng.init(dupire.simDim());
+    vector<double> g(dupire.simDim());
+    Scenario<double> path;
+    allocatePath(uoc.defline(), path);
+    initializePath(path);
+
+    const size_t paths = 20000;
+    bench("Dupire generatePath (100 steps)", paths, [&]() {
+      for (size_t p = 0; p < paths; ++p) {
+        rng.nextG(g);
+        dupire.generatePath(g, path);
+      }
+    });
+
+    vector<double> pay(2);
+    bench("UOC payoffs", paths, [&]() {
+      for (size_t p = 0; p < paths; ++p)
+        uoc.payoffs(path, pay);
+      sink += pay[0];
+    });
+
+    European<double> euro(100.0, 1.0, 1.0);
+    Scenario<double> ePath;
+    allocatePath(euro.defline(), ePath);
+    initializePath(ePath);
+    vector<double> ePay(1);
+    bench("European payoffs", paths, [&]() {
+      for (size_t p = 0; p < paths; ++p)
+        euro.payoffs(ePath, ePay);
+      sink += ePay[0];
+    });
+
+    ContingentBond<double> cb(2.0, 0.02, 0.25, 0.01);
+    Scenario<double> cbPath;
+    allocatePath(cb.defline(), cbPath);
+    initializePath(cbPath);
+    vector<double> cbPay(1);
+    bench("ContingentBond payoffs", paths, [&]() {
+      for (size_t p = 0; p < paths; ++p)
+        cb.payoffs(cbPath, cbPay);
+      sink += cbPay[0];
+    });
+  }
+
+  //  End to end: parallel AAD scaling over the thread pool
+  {
+    putBlackScholes(100.0, 0.2, false, 0.03, 0.0, "benchBS");
+    putBarrier(100.0, 130.0, 1.0, 1.0 / 12, 0.02, false, "benchUOC");
+    const Model<Number> *mdl = getModel<Number>("benchBS");
+    const Product<Number> *prd = getProduct<Number>("benchUOC");
+    Sobol rng;
+    const size_t paths = 20000;
+
+    const size_t maxThreads = thread::hardware_concurrency();
+    for (size_t nThread = 1; nThread <= maxThreads; nThread *= 2) {
+      ThreadPool::getInstance()->start(nThread);
+      char name[64];
+      snprintf(name, sizeof(name), "mcParallelSimulAAD (%zu thread%s)",
+               nThread, nThread > 1 ? "s" : "");
+      bench(name, paths, [&]() {
+        auto res = mcParallelSimulAAD(*prd, *mdl, rng, paths);
+        sink += res.risks[0];
+      });
+      ThreadPool::getInstance()->stop();
+    }
+  }
+
+  //  Keep the sink alive
+  printf("(checksum %g)\n", sink);
+  return 0;
+}
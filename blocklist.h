@@ -29,8 +29,13 @@ As long as this comment is preserved at the top of the file
 using namespace std;
 
 template <class T, size_t block_size> class blocklist {
+  //  One block, aligned on a cache line so SIMD kernels
+  //      (e.g. multi-dimensional adjoint propagation)
+  //      can rely on the alignment of the stored chunks
+  struct alignas(64) block : array<T, block_size> {};
+
   //  Container = list of blocks
-  list<array<T, block_size>> data;
+  list<block> data;
 
   using list_iter = decltype(data.begin());
   using block_iter = decltype(data.back().begin());
@@ -81,6 +86,26 @@ public:
     newblock();
   }
 
+  //  Pre-allocate blocks so total capacity is at least n elements,
+  //      without moving the cursor: subsequent growth
+  //      walks the chained blocks instead of hitting the allocator
+  void reserve(const size_t n) {
+    size_t capacity = data.size() * block_size;
+    while (capacity < n) {
+      data.emplace_back();
+      capacity += block_size;
+    }
+    last_block = prev(data.end());
+  }
+
+  //  Number of elements currently in use
+  size_t used() {
+    size_t n = 0;
+    for (auto it = data.begin(); it != cur_block; ++it)
+      n += block_size;
+    return n + distance(cur_block->begin(), next_space);
+  }
+
   //  Rewind but keep all blocks
   void rewind() {
     cur_block = data.begin();
@@ -89,3 +89,45 @@ inline double invNormalCdf(const double p) {
 
   return sup ? r : -r;
 }
+
+//	Block version: transform n Uniforms into n Gaussians
+//  The central branch (|u - 0.5| < 0.42, ~84% of draws) is evaluated
+//      in a tight branch-free polynomial loop the compiler can vectorize,
+//      the rare tails are fixed up in a second scalar pass
+//  Results are identical to invNormalCdf applied element-wise
+//  src and dst must not overlap: the tail pass re-reads the Uniforms
+inline void invNormalCdfBlock(const double *src, double *dst, const size_t n) {
+  static constexpr double a0 = 2.50662823884;
+  static constexpr double a1 = -18.61500062529;
+  static constexpr double a2 = 41.39119773534;
+  static constexpr double a3 = -25.44106049637;
+
+  static constexpr double b0 = -8.47351093090;
+  static constexpr double b1 = 23.08336743743;
+  static constexpr double b2 = -21.06224101826;
+  static constexpr double b3 = 3.13082909833;
+
+  //  Central pass, vectorizable: all lanes run the rational approximation
+  size_t tails = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const double p = src[i];
+    const double up = p > 0.5 ? 1.0 - p : p;
+    const double x = up - 0.5;
+    const double r = x * x;
+    const double central = x * (((a3 * r + a2) * r + a1) * r + a0) /
+                           ((((b3 * r + b2) * r + b1) * r + b0) * r + 1.0);
+    dst[i] = p > 0.5 ? -central : central;
+    //  Count (rather than branch on) the tail lanes
+    tails += fabs(x) >= 0.42;
+  }
+
+  //  Tail pass, scalar, rare
+  if (tails) {
+    for (size_t i = 0; i < n; ++i) {
+      const double p = src[i];
+      const double up = p > 0.5 ? 1.0 - p : p;
+      if (fabs(up - 0.5) >= 0.42)
+        dst[i] = invNormalCdf(p);
+    }
+  }
+}
@@ -23,6 +23,7 @@ As long as this comment is preserved at the top of the file
 #include "mcPrd.h"
 #include "mcPrdMulti.h"
 #include "mrg32k3a.h"
+#include "philox.h"
 #include "sobol.h"
 #include <fstream>
 #include <numeric>
@@ -36,30 +37,202 @@ struct NumericalParam {
   int numPath;
   int seed1 = 12345;
   int seed2 = 1234;
+  //  Counter based generator (philox.h) instead of mrg32k3a
+  //      when Sobol is not selected
+  bool usePhilox = false;
+  //  Single precision path generation and payoffs,
+  //      results accumulated in double (plain valuation only)
+  bool useFloat = false;
+};
+
+//  The RNG for the given numerical parameters
+inline unique_ptr<RNG> makeRng(const NumericalParam &num) {
+  if (num.useSobol)
+    return make_unique<Sobol>();
+  if (num.usePhilox)
+    return make_unique<Philox>(num.seed1, num.seed2);
+  return make_unique<mrg32k3a>(num.seed1, num.seed2);
+}
+
+//  Valuation results: the payoff identifiers and their values
+struct ValueResults {
+  vector<string> identifiers;
+  vector<double> values;
 };
 
 //  Price product in model
-inline auto value(const Model<double> &model, const Product<double> &product,
-                  //  numerical parameters
-                  const NumericalParam &num) {
+inline ValueResults value(const Model<double> &model,
+                          const Product<double> &product,
+                          //  numerical parameters
+                          const NumericalParam &num) {
   //  Random Number Generator
-  unique_ptr<RNG> rng;
-  if (num.useSobol)
-    rng = make_unique<Sobol>();
-  else
-    rng = make_unique<mrg32k3a>(num.seed1, num.seed2);
+  unique_ptr<RNG> rng = makeRng(num);
 
   //  Simulate
   const auto resultMat =
       num.parallel ? mcParallelSimul(product, model, *rng, num.numPath)
                    : mcSimul(product, model, *rng, num.numPath);
 
-  //  We return 2 vectors : the payoff identifiers and their values
+  ValueResults results;
+
+  const size_t nPayoffs = product.payoffLabels().size();
+  results.identifiers = product.payoffLabels();
+  results.values.resize(nPayoffs);
+  for (size_t i = 0; i < nPayoffs; ++i) {
+    results.values[i] =
+        accumulate(resultMat.begin(), resultMat.end(), 0.0,
+                   [i](const double acc, const vector<double> &v) {
+                     return acc + v[i];
+                   }) /
+        num.numPath;
+  }
+
+  return results;
+}
+
+//  Price product in model, streaming mode:
+//      no nPath x nPay results matrix, O(nPay) memory,
+//      and standard errors come for free
+inline auto valueStream(const string &modelId, const string &productId,
+                        const NumericalParam &num) {
+  const Model<double> *model = getModel<double>(modelId);
+  const Product<double> *product = getProduct<double>(productId);
+
+  if (!model || !product) {
+    throw runtime_error("valueStream() : Could not retrieve model and product");
+  }
+
+  //  Random Number Generator
+  unique_ptr<RNG> rng = makeRng(num);
+
+  //  Simulate into a running accumulator
+  SimulAccumulator acc;
+  if (num.parallel)
+    mcParallelSimulStream(*product, *model, *rng, num.numPath, acc);
+  else
+    mcSimulStream(*product, *model, *rng, num.numPath, acc);
+
+  //  We return 3 vectors:
+  //      the payoff identifiers, their values and standard errors
   struct {
     vector<string> identifiers;
     vector<double> values;
+    vector<double> stdErrs;
   } results;
 
+  const size_t nPayoffs = product->payoffLabels().size();
+  results.identifiers = product->payoffLabels();
+  results.values.resize(nPayoffs);
+  results.stdErrs.resize(nPayoffs);
+  for (size_t i = 0; i < nPayoffs; ++i) {
+    results.values[i] = acc.mean(i);
+    results.stdErrs[i] = acc.stdErr(i);
+  }
+
+  return results;
+}
+
+//  Persistent pricing session, chapter 6 entry points without the setup
+//  Keeps the cloned model, allocated scenario and initialized RNG alive
+//      across calls, so repricing the same (model, product) pair
+//      after a parameter change re-runs only init and the path loop
+//  The real time services price the same pair thousands of times a day:
+//      for small-nPath requests the setup is a large share of wall time
+class PricingSession {
+  const Product<double> *myProduct;
+  unique_ptr<Model<double>> myModel;
+
+  //  Pristine RNG, initialized once, cloned per call
+  //      so every call sees the same sequence
+  unique_ptr<RNG> myRng;
+
+  //  Reusable workspace
+  Scenario<double> myPath;
+  vector<double> myGaussVec;
+  vector<double> myPayoffs;
+
+public:
+  PricingSession(const string &modelId, const string &productId,
+                 const bool useSobol, const int seed1 = 12345,
+                 const int seed2 = 1234) {
+    const Model<double> *model = getModel<double>(modelId);
+    myProduct = getProduct<double>(productId);
+
+    if (!model || !myProduct) {
+      throw runtime_error(
+          "PricingSession() : Could not retrieve model and product");
+    }
+
+    if (!checkCompatiblity(*myProduct, *model))
+      throw runtime_error("Model and product are not compatible");
+
+    //  One-off setup: clone, allocate, size the workspace
+    myModel = model->clone();
+    myModel->allocate(myProduct->timeline(), myProduct->defline());
+    allocatePath(myProduct->defline(), myPath);
+    initializePath(myPath);
+    myGaussVec.resize(myModel->simDim());
+    myPayoffs.resize(myProduct->payoffLabels().size());
+
+    if (useSobol)
+      myRng = make_unique<Sobol>();
+    else
+      myRng = make_unique<mrg32k3a>(seed1, seed2);
+    myRng->init(myModel->simDim());
+  }
+
+  //  Access to the session's own model parameters,
+  //      bump them directly between calls
+  const vector<string> &parameterLabels() const {
+    return myModel->parameterLabels();
+  }
+  const vector<double *> &parameters() { return myModel->parameters(); }
+
+  //  Labels of the priced payoffs
+  const vector<string> &payoffLabels() const {
+    return myProduct->payoffLabels();
+  }
+
+  //  Price: re-runs only init and the path loop,
+  //      all buffers and the RNG state are reused
+  vector<double> value(const size_t nPath) {
+    //  Pre-calculate with the current parameters
+    myModel->init(myProduct->timeline(), myProduct->defline());
+
+    //  Same sequence on every call
+    auto rng = myRng->clone();
+
+    const size_t nPay = myPayoffs.size();
+    vector<double> values(nPay, 0.0);
+
+    for (size_t i = 0; i < nPath; i++) {
+      rng->nextG(myGaussVec);
+      myModel->generatePath(myGaussVec, myPath);
+      myProduct->payoffs(myPath, myPayoffs);
+      for (size_t j = 0; j < nPay; ++j)
+        values[j] += myPayoffs[j];
+    }
+
+    for (auto &v : values)
+      v /= nPath;
+
+    return values;
+  }
+};
+
+//  Price product in model, single precision engines
+inline ValueResults valueFloat(const Model<float> &model,
+                               const Product<float> &product,
+                               const NumericalParam &num) {
+  unique_ptr<RNG> rng = makeRng(num);
+
+  //  Simulate in float, accumulate in double
+  const auto resultMat =
+      num.parallel ? mcParallelSimul<float>(product, model, *rng, num.numPath)
+                   : mcSimul<float>(product, model, *rng, num.numPath);
+
+  ValueResults results;
+
   const size_t nPayoffs = product.payoffLabels().size();
   results.identifiers = product.payoffLabels();
   results.values.resize(nPayoffs);
@@ -76,9 +249,21 @@ inline auto value(const Model<double> &model, const Product<double> &product,
 }
 
 //  Overload that picks product and model by name in the store
-inline auto value(const string &modelId, const string &productId,
-                  //  numerical parameters
-                  const NumericalParam &num) {
+inline ValueResults value(const string &modelId, const string &productId,
+                          //  numerical parameters
+                          const NumericalParam &num) {
+  //  Single precision mode
+  if (num.useFloat) {
+    const Model<float> *model = getModel<float>(modelId);
+    const Product<float> *product = getProduct<float>(productId);
+
+    if (!model || !product) {
+      throw runtime_error("value() : Could not retrieve model and product");
+    }
+
+    return valueFloat(*model, *product, num);
+  }
+
   //  Get model and product
   const Model<double> *model = getModel<double>(modelId);
   const Product<double> *product = getProduct<double>(productId);
@@ -103,11 +288,7 @@ inline auto AADriskOne(const string &modelId, const string &productId,
   }
 
   //  Random Number Generator
-  unique_ptr<RNG> rng;
-  if (num.useSobol)
-    rng = make_unique<Sobol>();
-  else
-    rng = make_unique<mrg32k3a>(num.seed1, num.seed2);
+  unique_ptr<RNG> rng = makeRng(num);
 
   //  Find the payoff for risk
   size_t riskPayoffIdx = 0;
@@ -166,6 +347,82 @@ inline auto AADriskOne(const string &modelId, const string &productId,
   return results;
 }
 
+//  Asynchronous pricing tier
+//  =========================
+//  Submit a whole pricing request to the thread pool and return a
+//      future immediately; the caller (e.g. the xlCpp addin or the
+//      service layer) no longer blocks for the simulation, and
+//      concurrent requests share the pool - their batches interleave
+//      instead of each request monopolizing the machine.
+//  The executing thread gets a fresh tape for the request's duration
+//      so the AAD entry points run safely from a worker.
+
+template <class F> inline auto asyncRequest(F request) {
+  using R = decltype(request());
+  auto prom = make_shared<promise<R>>();
+  auto fut = prom->get_future();
+
+  ThreadPool::getInstance()->spawnTask([prom, request]() {
+    //  Fresh tape for the request, restored on exit
+    Tape *previous = Number::tape;
+    Tape requestTape;
+    Number::tape = &requestTape;
+
+    try {
+      prom->set_value(request());
+    } catch (...) {
+      prom->set_exception(current_exception());
+    }
+
+    Number::tape = previous;
+    return true;
+  });
+
+  return fut;
+}
+
+//  Future forms of the entry points
+
+inline future<ValueResults> valueAsync(const string &modelId,
+                                       const string &productId,
+                                       const NumericalParam &num) {
+  return asyncRequest(
+      [modelId, productId, num]() { return value(modelId, productId, num); });
+}
+
+inline auto AADriskOneAsync(const string &modelId, const string &productId,
+                            const NumericalParam &num,
+                            const string &riskPayoff = "") {
+  return asyncRequest([modelId, productId, num, riskPayoff]() {
+    return AADriskOne(modelId, productId, num, riskPayoff);
+  });
+}
+
+//  Callback form for the service layer: the callback runs on the
+//      executing thread when the request completes
+template <class CB>
+inline void valueAsync(const string &modelId, const string &productId,
+                       const NumericalParam &num, CB callback) {
+  ThreadPool::getInstance()->spawnTask([modelId, productId, num, callback]() {
+    Tape *previous = Number::tape;
+    Tape requestTape;
+    Number::tape = &requestTape;
+
+    //  The tape is restored on every path; a throwing request
+    //      surfaces through the task's (unobserved) future,
+    //      so service callbacks should catch their own errors
+    try {
+      callback(value(modelId, productId, num));
+    } catch (...) {
+      Number::tape = previous;
+      throw;
+    }
+
+    Number::tape = previous;
+    return true;
+  });
+}
+
 //  AAD risk, aggregate portfolio
 inline auto AADriskAggregate(const string &modelId, const string &productId,
                              const map<string, double> &notionals,
@@ -180,11 +437,7 @@ inline auto AADriskAggregate(const string &modelId, const string &productId,
   }
 
   //  Random Number Generator
-  unique_ptr<RNG> rng;
-  if (num.useSobol)
-    rng = make_unique<Sobol>();
-  else
-    rng = make_unique<mrg32k3a>(num.seed1, num.seed2);
+  unique_ptr<RNG> rng = makeRng(num);
 
   //  Vector of notionals
   const vector<string> &allPayoffs = product->payoffLabels();
@@ -267,11 +520,7 @@ inline RiskReports AADriskMulti(const string &modelId, const string &productId,
   RiskReports results;
 
   //  Random Number Generator
-  unique_ptr<RNG> rng;
-  if (num.useSobol)
-    rng = make_unique<Sobol>();
-  else
-    rng = make_unique<mrg32k3a>(num.seed1, num.seed2);
+  unique_ptr<RNG> rng = makeRng(num);
 
   //  Simulate
   const auto simulResults =
@@ -301,6 +550,11 @@ inline RiskReports AADriskMulti(const string &modelId, const string &productId,
 
 //  Bump risk, itemized
 //  Same result format as AADriskMulti()
+//  The Gaussians are generated once into a shared read-only cache
+//      and replayed by every revaluation,
+//      and the bumps run in parallel over the thread pool:
+//      each bump owns a model clone and redoes only
+//      generatePath + payoffs over the cached numbers
 inline RiskReports bumpRisk(const string &modelId, const string &productId,
                             const NumericalParam &num) {
   auto *orig = getModel<double>(modelId);
@@ -312,30 +566,59 @@ inline RiskReports bumpRisk(const string &modelId, const string &productId,
 
   RiskReports results;
 
-  //  base values
-  auto baseRes = value(*orig, *product, num);
-  results.payoffs = baseRes.identifiers;
-  results.values = baseRes.values;
+  //  Source generator, used once to fill the cache
+  unique_ptr<RNG> src = makeRng(num);
+
+  //  Find the simulation dimension
+  auto dimMdl = orig->clone();
+  dimMdl->allocate(product->timeline(), product->defline());
+  const size_t simDim = dimMdl->simDim();
+
+  //  The shared Gaussian cache
+  PrecomputedRNG cachedRng(*src, num.numPath, simDim);
+
+  //  Average the payoffs of a simulation over the cached numbers
+  auto averages = [&](const Model<double> &mdl) {
+    const auto resultMat = mcSimul(*product, mdl, cachedRng, num.numPath);
+    const size_t nPayoffs = product->payoffLabels().size();
+    vector<double> values(nPayoffs);
+    for (size_t i = 0; i < nPayoffs; ++i) {
+      values[i] = accumulate(resultMat.begin(), resultMat.end(), 0.0,
+                             [i](const double acc, const vector<double> &v) {
+                               return acc + v[i];
+                             }) /
+                  num.numPath;
+    }
+    return values;
+  };
 
-  //  make copy so we don't modify the model in memory
-  auto model = orig->clone();
+  //  base values
+  results.payoffs = product->payoffLabels();
+  results.values = averages(*orig);
 
-  results.params = model->parameterLabels();
-  const vector<double *> parameters = model->parameters();
-  const size_t n = parameters.size(), m = results.payoffs.size();
+  results.params = orig->parameterLabels();
+  const size_t n = results.params.size(), m = results.payoffs.size();
   results.risks.resize(n, m);
 
-  //  bumps
-  for (size_t i = 0; i < n; ++i) {
-    *parameters[i] += 1.e-08;
-    auto bumpRes = value(*model, *product, num);
-    *parameters[i] -= 1.e-08;
+  //  bumps, embarrassingly parallel: one task per parameter,
+  //      each on its own model clone
+  ThreadPool *pool = ThreadPool::getInstance();
+  TaskGroup bumps;
 
-    for (size_t j = 0; j < m; ++j) {
-      results.risks[i][j] = 1.0e+08 * (bumpRes.values[j] - baseRes.values[j]);
-    }
+  for (size_t i = 0; i < n; ++i) {
+    pool->spawnTask(bumps, [&, i]() {
+      auto model = orig->clone();
+      *model->parameters()[i] += 1.e-08;
+      const auto bumpValues = averages(*model);
+
+      for (size_t j = 0; j < m; ++j) {
+        results.risks[i][j] = 1.0e+08 * (bumpValues[j] - results.values[j]);
+      }
+    });
   }
 
+  pool->activeWait(bumps);
+
   return results;
 }
 
@@ -600,12 +883,13 @@ inline auto dupireSuperbucketBump(
     for (size_t j = 0; j < m; ++j) {
       //  Bump
       riskView.bump(i, j, 1.0e-05);
-      //  Recalibrate
-      auto bumpedCalib =
-          dupireCalib(ivs, inclSpots, maxDs, inclTimes, maxDtVol, riskView);
+      //  Recalibrate incrementally: the knot bump only moves the
+      //      surface between the neighboring view maturities,
+      //      the other columns are kept from the base calibration
+      matrix<double> bumpedLVols = lvols;
+      dupireCalibIncremental(ivs, spots, times, bumpedLVols, riskView, j);
       //  Recreate model
-      Dupire<double> bumpedModel(spot, bumpedCalib.spots, bumpedCalib.times,
-                                 bumpedCalib.lVols, maxDt);
+      Dupire<double> bumpedModel(spot, spots, times, bumpedLVols, maxDt);
       //  Reprice
       auto bumpedVals = value(bumpedModel, *product, num);
       //  Pick results and differentiate
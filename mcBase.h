@@ -21,8 +21,11 @@ As long as this comment is preserved at the top of the file
 //  See chapters 6, 7, 12 and 14
 
 #include "AAD.h"
+#include "AADCompact.h"
+#include "mcProfile.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <memory>
 #include <numeric>
@@ -62,24 +65,85 @@ struct SampleDef {
   vector<vector<Time>> forwardMats;
 };
 
+//  Non-owning view on a contiguous range of simulated data,
+//      lives in the Scenario's backing arena
+//  Implements the subset of the vector interface used by models and products
+template <class T> class dataspan {
+  T *myBegin;
+  size_t mySize;
+
+public:
+  dataspan() : myBegin(nullptr), mySize(0) {}
+  dataspan(T *begin, const size_t size) : myBegin(begin), mySize(size) {}
+
+  //  Rewire on the arena, keep the size
+  void rebind(T *begin) { myBegin = begin; }
+
+  size_t size() const { return mySize; }
+  bool empty() const { return mySize == 0; }
+
+  T *begin() { return myBegin; }
+  T *end() { return myBegin + mySize; }
+  const T *begin() const { return myBegin; }
+  const T *end() const { return myBegin + mySize; }
+
+  T &operator[](const size_t i) { return myBegin[i]; }
+  const T &operator[](const size_t i) const { return myBegin[i]; }
+
+  T &front() { return *myBegin; }
+  const T &front() const { return *myBegin; }
+  T &back() { return myBegin[mySize - 1]; }
+  const T &back() const { return myBegin[mySize - 1]; }
+};
+
 //  Sample = simulated value
 //      of data on a given event date
+//  Views into the Scenario's flat arena,
+//      one contiguous chunk per event date
 template <class T> struct Sample {
   T numeraire;
-  vector<T> discounts;
-  vector<T> libors;
+  dataspan<T> discounts;
+  dataspan<T> libors;
 
   //  multi-asset: forwardMats[a][t] = forward for asset a, maturity t
-  vector<vector<T>> forwards;
+  vector<dataspan<T>> forwards;
+
+  //  Number of data points in the arena for this sample
+  static size_t dataSize(const SampleDef &data) {
+    size_t size = data.discountMats.size() + data.liborDefs.size();
+    for (const auto &mats : data.forwardMats)
+      size += mats.size();
+    return size;
+  }
 
-  //  Allocate given SampleDef
-  void allocate(const SampleDef &data) {
-    discounts.resize(data.discountMats.size());
-    libors.resize(data.liborDefs.size());
+  //  Wire the views on the arena given SampleDef,
+  //      advance the arena cursor
+  void bind(const SampleDef &data, T *&next) {
+    discounts = dataspan<T>(next, data.discountMats.size());
+    next += discounts.size();
+
+    libors = dataspan<T>(next, data.liborDefs.size());
+    next += libors.size();
 
     forwards.resize(data.forwardMats.size());
-    for (size_t a = 0; a < forwards.size(); ++a)
-      forwards[a].resize(data.forwardMats[a].size());
+    for (size_t a = 0; a < forwards.size(); ++a) {
+      forwards[a] = dataspan<T>(next, data.forwardMats[a].size());
+      next += forwards[a].size();
+    }
+  }
+
+  //  Rewire the views on a copied arena, sizes unchanged
+  void rebind(T *&next) {
+    discounts.rebind(next);
+    next += discounts.size();
+
+    libors.rebind(next);
+    next += libors.size();
+
+    for (auto &forward : forwards) {
+      forward.rebind(next);
+      next += forward.size();
+    }
   }
 
   //  Initialize defaults
@@ -93,14 +157,82 @@ template <class T> struct Sample {
   }
 };
 
-template <class T> using Scenario = vector<Sample<T>>;
+//  Scenario = collection of samples
+//      backed by one flat arena so path generation and payoffs
+//      walk a single contiguous buffer
+template <class T> class Scenario {
+  //  The arena: all the samples' data, one contiguous buffer
+  vector<T> myData;
+
+  //  The samples, views into the arena
+  vector<Sample<T>> mySamples;
+
+  //  Rewire all samples on myData, in binding order
+  void rebind() {
+    T *next = myData.data();
+    for (auto &sample : mySamples)
+      sample.rebind(next);
+  }
+
+public:
+  Scenario() {}
+
+  //  Copy and move must rewire the views on the copied arena
+  Scenario(const Scenario &rhs)
+      : myData(rhs.myData), mySamples(rhs.mySamples) {
+    rebind();
+  }
+  Scenario &operator=(const Scenario &rhs) {
+    if (this == &rhs)
+      return *this;
+    myData = rhs.myData;
+    mySamples = rhs.mySamples;
+    rebind();
+    return *this;
+  }
+
+  //  Moving the vector keeps the arena in place: views remain valid
+  Scenario(Scenario &&rhs) = default;
+  Scenario &operator=(Scenario &&rhs) = default;
+
+  //  Allocate the arena and wire the samples, given the defline
+  void allocate(const vector<SampleDef> &defline) {
+    size_t dataSize = 0;
+    for (const auto &def : defline)
+      dataSize += Sample<T>::dataSize(def);
+
+    //  One allocation for the whole path
+    myData.resize(dataSize);
+    mySamples.resize(defline.size());
+
+    T *next = myData.data();
+    for (size_t i = 0; i < defline.size(); ++i)
+      mySamples[i].bind(defline[i], next);
+  }
+
+  //  Access, same interface as the former vector of samples
+  size_t size() const { return mySamples.size(); }
+  bool empty() const { return mySamples.empty(); }
+
+  Sample<T> &operator[](const size_t i) { return mySamples[i]; }
+  const Sample<T> &operator[](const size_t i) const { return mySamples[i]; }
+
+  Sample<T> &front() { return mySamples.front(); }
+  const Sample<T> &front() const { return mySamples.front(); }
+  Sample<T> &back() { return mySamples.back(); }
+  const Sample<T> &back() const { return mySamples.back(); }
+
+  typedef typename vector<Sample<T>>::iterator iterator;
+  typedef typename vector<Sample<T>>::const_iterator const_iterator;
+  iterator begin() { return mySamples.begin(); }
+  iterator end() { return mySamples.end(); }
+  const_iterator begin() const { return mySamples.begin(); }
+  const_iterator end() const { return mySamples.end(); }
+};
 
 template <class T>
 inline void allocatePath(const vector<SampleDef> &defline, Scenario<T> &path) {
-  path.resize(defline.size());
-  for (size_t i = 0; i < defline.size(); ++i) {
-    path[i].allocate(defline[i]);
-  }
+  path.allocate(defline);
 }
 
 template <class T> inline void initializePath(Scenario<T> &path) {
@@ -134,6 +266,31 @@ public:
       //  pre-allocated space for resulting payoffs
       vector<T> &payoffs) const = 0;
 
+  //  Early termination support, see mcSimulEarlyExit in this file:
+  //      knock-out style products whose payoff may be fully determined
+  //      before the last event date can expose a per-event check,
+  //      letting the engine stop advancing a dead path
+  //  A product that opts in must guarantee that payoffs() gives no
+  //      weight to samples beyond the event it reported terminated
+  virtual bool supportsEarlyExit() const { return false; }
+
+  //  Is the payoff fully determined once the path
+  //      is filled up to event (inclusive)?
+  virtual bool terminated(const Scenario<T> &path, const size_t event) const {
+    return false;
+  }
+
+  //  Static payoff kernels, see mcSimulAADStatic:
+  //      single payoff products whose payoff is one expression of the
+  //      samples may evaluate it record-free on the Number
+  //      instantiation, accumulating the payoff adjoints straight
+  //      into the samples' nodes so the tape only ever carries
+  //      the model section
+  virtual bool supportsStaticPayoff() const { return false; }
+
+  //  Evaluate the payoff and seed the sample adjoints (weight 1)
+  virtual double staticPayoff(const Scenario<T> &path) const { return 0.0; }
+
   virtual unique_ptr<Product<T>> clone() const = 0;
 
   virtual ~Product() {}
@@ -159,11 +316,72 @@ public:
   //  Access to the MC dimension
   virtual size_t simDim() const = 0;
 
+  //  Access to the simulation timeline, where the model exposes one
+  //      (single factor models consuming one Gaussian per step):
+  //      required by the multilevel engine to couple the levels'
+  //      Brownian increments; null when not applicable
+  virtual const vector<Time> *simTimeline() const { return nullptr; }
+
   //  Generate a path consuming a vector[simDim()] of independent Gaussians
   //  return results in a pre-allocated scenario
   virtual void generatePath(const vector<double> &gaussVec,
                             Scenario<T> &path) const = 0;
 
+  //  Generate a batch of paths,
+  //      consuming one row[simDim()] of Gaussians per path
+  //  Models may override with a vectorized kernel
+  //      that advances all the paths in the batch simultaneously
+  //  Default: one path at a time
+  virtual void generatePaths(const matrix<double> &gaussVecs,
+                             Scenario<T> *const *paths,
+                             const size_t nPaths) const {
+    static thread_local vector<double> gaussVec;
+    gaussVec.resize(gaussVecs.cols());
+
+    for (size_t i = 0; i < nPaths; ++i) {
+      copy(gaussVecs[i], gaussVecs[i] + gaussVecs.cols(), gaussVec.begin());
+      generatePath(gaussVec, *paths[i]);
+    }
+  }
+
+  //  Optional segment-wise path generation,
+  //      required by the checkpointed AAD engine (below):
+  //      advance the path over a range of event dates at a time,
+  //      carrying the diffusion state across segment boundaries
+  //  Models that override these must produce, segment by segment,
+  //      exactly the path generatePath produces in one go
+  virtual bool supportsSegments() const { return false; }
+
+  //  The state at the first boundary (today)
+  virtual void initState(vector<T> &state) const {}
+
+  //  Fill path[firstEvent, lastEvent), consuming this segment's
+  //      Gaussians from the full vector[simDim()],
+  //      advancing state from the firstEvent to the lastEvent boundary
+  virtual void generateSegment(const vector<double> &gaussVec,
+                               Scenario<T> &path, vector<T> &state,
+                               const size_t firstEvent,
+                               const size_t lastEvent) const {}
+
+  //  Hybrid AAD, see mcSimulAADHybrid in this file:
+  //      models whose step has a closed form adjoint may generate
+  //      the path in plain double arithmetic, storing what the
+  //      backward pass needs, then push the samples' adjoints
+  //      analytically into their parameter adjoints - so the tape
+  //      only ever carries the payoff
+  virtual bool supportsPathAdjoints() const { return false; }
+
+  //  Generate one path, storing the backward pass workspace
+  virtual void generatePathStoring(const vector<double> &gaussVec,
+                                   Scenario<double> &path) {}
+
+  //  Consume the adjoints of the stored path's samples
+  //      (a scenario of the same shape holding dPayoff/dSample)
+  //      and accumulate into the parameter adjoints,
+  //      laid out like parameters()
+  virtual void propagatePathAdjoints(const Scenario<double> &pathAdjoints,
+                                     vector<double> &paramAdjoints) {}
+
   virtual unique_ptr<Model<T>> clone() const = 0;
 
   virtual ~Model() {}
@@ -182,6 +400,11 @@ template <class T>
 //  If T not Number : do nothing
 void putParametersOnTapeT(Model<T> &model) {}
 
+//  If T = Number : put on tape, see mcBase.cpp
+//  Declared here so instantiations pick the specialization,
+//      not the empty primary template
+template <> void putParametersOnTapeT<>(Model<Number> &model);
+
 //  Put parameters on tape, only valid for T = Number
 template <class T> void putModelParametersOnTape(Model<T> &model) {
   putParametersOnTapeT<T>(model);
@@ -204,6 +427,20 @@ public:
   virtual void nextU(vector<double> &uVec) = 0;
   virtual void nextG(vector<double> &gaussVec) = 0;
 
+  //  Compute the next nPoints vectors of independent Gaussians,
+  //      one per row of the pre-allocated matrix(nPoints, simDim)
+  //  Concrete generators override with a batched Gaussian transformation,
+  //      the default loops over nextG
+  virtual void nextGBlock(matrix<double> &gaussMat, const size_t nPoints) {
+    static thread_local vector<double> gaussVec;
+    gaussVec.resize(gaussMat.cols());
+
+    for (size_t i = 0; i < nPoints; ++i) {
+      nextG(gaussVec);
+      copy(gaussVec.begin(), gaussVec.end(), gaussMat[i]);
+    }
+  }
+
   virtual unique_ptr<RNG> clone() const = 0;
 
   virtual ~RNG() {}
@@ -212,6 +449,52 @@ public:
   virtual void skipTo(const unsigned b) = 0;
 };
 
+//  RNG replaying Gaussians pre-computed with a source generator
+//  Clones share the read-only cache, so many simulations
+//      (e.g. the revaluations of a bump risk report)
+//      replay the exact same numbers without regenerating them
+class PrecomputedRNG : public RNG {
+  //  The cache, one point per row, shared across clones
+  shared_ptr<const matrix<double>> myGaussians;
+
+  //  Current point
+  size_t myPoint;
+
+public:
+  //  Generate nPoints vectors of dimension simDim with the source
+  PrecomputedRNG(RNG &src, const size_t nPoints, const size_t simDim)
+      : myPoint(0) {
+    auto cache = make_shared<matrix<double>>(nPoints, simDim);
+    src.init(simDim);
+    src.nextGBlock(*cache, nPoints);
+    myGaussians = move(cache);
+  }
+
+  //  Number of cached points
+  size_t nPoints() const { return myGaussians->rows(); }
+
+  unique_ptr<RNG> clone() const override {
+    return make_unique<PrecomputedRNG>(*this);
+  }
+
+  void init(const size_t simDim) override {
+    if (simDim != myGaussians->cols())
+      throw runtime_error("PrecomputedRNG : dimension mismatch with cache");
+    myPoint = 0;
+  }
+
+  void nextU(vector<double> &uVec) override {
+    throw runtime_error("PrecomputedRNG : only Gaussians are cached");
+  }
+
+  void nextG(vector<double> &gaussVec) override {
+    const double *row = (*myGaussians)[myPoint++];
+    copy(row, row + myGaussians->cols(), gaussVec.begin());
+  }
+
+  void skipTo(const unsigned b) override { myPoint = b; }
+};
+
 //  Template algorithms
 //  ===================
 
@@ -228,8 +511,12 @@ inline bool checkCompatiblity(const Product<T> &prd, const Model<T> &mdl) {
 //	MC simulator: free function that conducts simulations
 //      and returns a matrix (as vector of vectors) of payoffs
 //          (0..nPath-1 , 0..nPay-1)
-inline vector<vector<double>> mcSimul(const Product<double> &prd,
-                                      const Model<double> &mdl, const RNG &rng,
+//  Templated on the value type V: the plain-value engines also run
+//      in single precision (V = float), halving the scenario
+//      footprint, with the results accumulated in double
+template <class V = double>
+inline vector<vector<double>> mcSimul(const Product<V> &prd,
+                                      const Model<V> &mdl, const RNG &rng,
                                       const size_t nPath) {
   if (!checkCompatiblity(prd, mdl))
     throw runtime_error("Model and product are not compatible");
@@ -251,226 +538,1308 @@ inline vector<vector<double>> mcSimul(const Product<double> &prd,
   //  Allocate Gaussian vector
   vector<double> gaussVec(cMdl->simDim());
   //  Allocate path
+  Scenario<V> path;
+  allocatePath(prd.defline(), path);
+  initializePath(path);
+
+  //  Payoff workspace, in the engine's precision
+  vector<V> payoffs(nPay);
+
+  //	Iterate through paths
+  for (size_t i = 0; i < nPath; i++) {
+    //  Next Gaussian vector, dimension D
+    {
+      MCPROFILE_SCOPE(mcPhaseRng);
+      cRng->nextG(gaussVec);
+    }
+    //  Generate path, consume Gaussian vector
+    {
+      MCPROFILE_SCOPE(mcPhasePath);
+      cMdl->generatePath(gaussVec, path);
+    }
+    //	Compute result, accumulate in double
+    {
+      MCPROFILE_SCOPE(mcPhasePayoffs);
+      prd.payoffs(path, payoffs);
+      copy(payoffs.begin(), payoffs.end(), results[i].begin());
+    }
+  }
+
+  return results; //	C++11: move
+}
+
+//  Parallel valuation, chapter 7
+
+//  Parallel grain
+//  The first task of every parallel run simulates MINBATCH paths
+//      and is timed on the spot; the remaining tasks are sized
+//      so each takes roughly TASKTARGETMICROS microseconds,
+//      subject to keeping enough tasks in flight for load balance
+//  Callers may override with an explicit batch size hint
+constexpr size_t MINBATCH = 64;
+constexpr double TASKTARGETMICROS = 5000.0;
+
+//  Number of paths advanced simultaneously
+//      by the batch path generation kernels,
+//      also the pipeline stage of mcParallelSimul
+constexpr size_t PATHBLOCK = 32;
+
+//  Pick the parallel batch size
+//      from the measured cost of the calibration batch
+inline size_t adaptiveBatchSize(
+    //  total paths and threads
+    const size_t nPath, const size_t nThread,
+    //  measured calibration batch
+    const size_t measuredPaths, const double measuredMicros,
+    //  explicit override, 0 = adaptive
+    const size_t hint) {
+  if (hint)
+    return hint;
+  if (!measuredPaths || measuredMicros <= 0.0)
+    return MINBATCH;
+
+  //  Target a fixed task duration
+  const double perPath = measuredMicros / measuredPaths;
+  size_t batch = size_t(TASKTARGETMICROS / perPath) + 1;
+
+  //  Keep at least 4 tasks per thread in flight for load balance
+  batch = min(batch, nPath / (4 * (nThread + 1)) + 1);
+  //  And never a smaller grain than a path block
+  batch = max(batch, PATHBLOCK);
+
+  //  Round down to a power of 2: repeated runs land on the same grain
+  //      despite timing jitter, so results stay reproducible in practice
+  //  (results are accumulated per batch, so the exact grain
+  //      affects floating point summation order,
+  //      well within the Monte-Carlo noise;
+  //      pass a hint for bit-exact reproducibility)
+  size_t pow2 = PATHBLOCK;
+  while (2 * pow2 <= batch)
+    pow2 *= 2;
+
+  return pow2;
+}
+//	Parallel equivalent of mcSimul()
+template <class V = double>
+inline vector<vector<double>> mcParallelSimul(const Product<V> &prd,
+                                              const Model<V> &mdl,
+                                              const RNG &rng, const size_t nPath,
+                                              //  0 = pick the batch size
+                                              //      adaptively, see above
+                                              const size_t batchSizeHint = 0) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+
+  auto cMdl = mdl.clone();
+
+  const size_t nPay = prd.payoffLabels().size();
+  vector<vector<double>> results(nPath, vector<double>(nPay));
+
+  cMdl->allocate(prd.timeline(), prd.defline());
+  cMdl->init(prd.timeline(), prd.defline());
+
+  //  Space for Gaussian vectors and path blocks,
+  //      one block of PATHBLOCK paths for each thread
+  //      so the model's batch kernel advances whole blocks at once
+  //  Workers allocate their own workspace on first use (below),
+  //      so first touch places the pages on the worker's NUMA node
+  ThreadPool *pool = ThreadPool::getInstance();
+  const size_t nThread = pool->numThreads();
+  vector<matrix<double>> gaussMats(nThread + 1); //  +1 for main
+  vector<vector<Scenario<V>>> pathBlocks(nThread + 1);
+  vector<vector<V>> payoffVecsT(nThread + 1);
+
+  //  Workspace allocated?
+  //  Note we don't use vector<bool>
+  //      because vector<bool> is not thread safe
+  vector<int> wsInit(nThread + 1, false);
+
+  //  One RNG per thread
+  vector<unique_ptr<RNG>> rngs(nThread + 1);
+  for (auto &random : rngs) {
+    random = rng.clone();
+    random->init(cMdl->simDim());
+  }
+
+  //  Double buffered Gaussian matrices for the pipeline
+  vector<matrix<double>> gaussMatsBack(nThread + 1);
+
+  //  The work for one batch of paths
+  //  On worker threads the stages are pipelined: while a block's
+  //      paths and payoffs are computed, the next block's Gaussians
+  //      are produced by a spawned sub-task (run by an idle thread
+  //      when one is available, by this thread otherwise), so the
+  //      integer-heavy generation overlaps the floating point work.
+  //  The main thread fills inline: its deque holds the batch tasks
+  //      themselves, which must not be re-entered from a wait
+  auto simulateBatch = [&](const size_t firstPath, const size_t pathsInTask) {
+    //  Inside the parallel task, pick this thread's workspace,
+    //      allocating it (first touch) on first use
+    const size_t threadNum = pool->threadNum();
+    if (!wsInit[threadNum]) {
+      gaussMats[threadNum].resize(PATHBLOCK, cMdl->simDim());
+      gaussMatsBack[threadNum].resize(PATHBLOCK, cMdl->simDim());
+      pathBlocks[threadNum].resize(PATHBLOCK);
+      for (auto &path : pathBlocks[threadNum]) {
+        allocatePath(prd.defline(), path);
+        initializePath(path);
+      }
+      wsInit[threadNum] = true;
+    }
+    matrix<double> *front = &gaussMats[threadNum];
+    matrix<double> *back = &gaussMatsBack[threadNum];
+    vector<Scenario<V>> &block = pathBlocks[threadNum];
+    vector<V> &payoffsV = payoffVecsT[threadNum];
+    payoffsV.resize(nPay);
+
+    //  Pointers on the block's scenarios for the batch kernel
+    Scenario<V> *pathPtrs[PATHBLOCK];
+    for (size_t k = 0; k < PATHBLOCK; ++k)
+      pathPtrs[k] = &block[k];
+
+    //  Get a RNG and position it correctly
+    auto &random = rngs[threadNum];
+    random->skipTo(firstPath);
+
+    const bool pipeline = threadNum > 0;
+
+    //  Fill the first block
+    size_t done = 0;
+    size_t nb = min(PATHBLOCK, pathsInTask);
+    {
+      MCPROFILE_SCOPE(mcPhaseRng);
+      random->nextGBlock(*front, nb);
+    }
+
+    while (done < pathsInTask) {
+      //  Produce the next block's Gaussians ahead
+      const size_t nbNext = min(PATHBLOCK, pathsInTask - done - nb);
+      TaskGroup fill;
+      if (nbNext) {
+        if (pipeline) {
+          pool->spawnTask(fill, [&random, back, nbNext]() {
+            MCPROFILE_SCOPE(mcPhaseRng);
+            random->nextGBlock(*back, nbNext);
+          });
+        } else {
+          MCPROFILE_SCOPE(mcPhaseRng);
+          random->nextGBlock(*back, nbNext);
+        }
+      }
+
+      //  Paths, whole block at once
+      {
+        MCPROFILE_SCOPE(mcPhasePath);
+        cMdl->generatePaths(*front, pathPtrs, nb);
+      }
+      //  Payoffs, accumulated in double
+      {
+        MCPROFILE_SCOPE(mcPhasePayoffs);
+        for (size_t k = 0; k < nb; ++k) {
+          prd.payoffs(block[k], payoffsV);
+          copy(payoffsV.begin(), payoffsV.end(),
+               results[firstPath + done + k].begin());
+        }
+      }
+
+      //  Join the producer: run it ourselves when still queued
+      //      (a worker's own deque only holds its own sub-tasks),
+      //      then synchronize before the group leaves scope
+      if (nbNext && pipeline) {
+        while (!fill.finished()) {
+          if (!pool->tryRunOwnTask())
+            this_thread::yield();
+        }
+        fill.sync();
+      }
+
+      done += nb;
+      nb = nbNext;
+      swap(front, back);
+    }
+  };
+
+  //  Calibration: time a first batch of MINBATCH paths
+  //      and size the remaining tasks accordingly
+  const size_t calibPaths = min<size_t>(nPath, MINBATCH);
+  const auto calibStart = chrono::high_resolution_clock::now();
+  simulateBatch(0, calibPaths);
+  const double calibMicros =
+      chrono::duration<double, micro>(chrono::high_resolution_clock::now() -
+                                      calibStart)
+          .count();
+  const size_t batchSize =
+      adaptiveBatchSize(nPath, nThread, calibPaths, calibMicros, batchSizeHint);
+
+  //  One completion object for the whole range of tasks
+  TaskGroup batches;
+
+  //  Start
+  //  Same as mcSimul() except we send tasks to the pool
+  //  instead of executing them
+
+  size_t firstPath = calibPaths;
+  size_t pathsLeft = nPath - calibPaths;
+  while (pathsLeft > 0) {
+    size_t pathsInTask = min<size_t>(pathsLeft, batchSize);
+
+    pool->spawnTask(batches, [&, firstPath, pathsInTask]() {
+      simulateBatch(firstPath, pathsInTask);
+    });
+
+    pathsLeft -= pathsInTask;
+    firstPath += pathsInTask;
+  }
+
+  //  Wait and help
+  pool->activeWait(batches);
+
+  return results; //	C++11: move
+}
+
+//  Multilevel Monte Carlo, Giles (2008)
+//  A hierarchy of time grids: level l prices with the model the
+//      factory builds for l (typically maxDt / 2^l), and the level
+//      estimators E[P_l - P_(l-1)] run coupled coarse/fine path
+//      pairs driven by the same Brownian increments, so most paths
+//      live on the cheap coarse grids
+//  The coupling aggregates the fine Gaussians over each coarse step
+//      (both timelines contain the product events; the aggregate is
+//      renormalized to unit variance), which is valid regardless of
+//      grid nesting: the telescoping expectation only needs each
+//      level simulated with genuine Gaussians, the coupling quality
+//      only drives the variance decay
+//  Single factor models only (one Gaussian per simulation step)
+
+struct MLMCResults {
+  //  Combined multilevel estimator of payoff[0] and its std error
+  double value;
+  double stdErr;
+
+  //  Per level: paths, level estimator mean and variance
+  struct Level {
+    size_t paths;
+    double mean;
+    double variance;
+  };
+  vector<Level> levels;
+};
+
+template <class FACTORY>
+inline MLMCResults mcSimulMLMC(
+    const Product<double> &prd,
+    //  Build the model of a level, e.g. Dupire with maxDt / 2^level
+    const FACTORY &makeModel, const RNG &rng,
+    //  Number of levels and paths on the first pass of every level
+    const size_t nLevels, const size_t initPaths,
+    //  Target standard error; 0 = one pass of initPaths per level
+    const double epsilon = 0.0) {
+  if (nLevels < 1)
+    throw runtime_error("mcSimulMLMC() : need at least one level");
+
+  //  Build, allocate and initialize the models of all the levels
+  vector<unique_ptr<Model<double>>> models(nLevels);
+  for (size_t l = 0; l < nLevels; ++l) {
+    models[l] = makeModel(l);
+    if (!checkCompatiblity(prd, *models[l]))
+      throw runtime_error("Model and product are not compatible");
+    models[l]->allocate(prd.timeline(), prd.defline());
+    models[l]->init(prd.timeline(), prd.defline());
+    if (!models[l]->simTimeline() ||
+        models[l]->simDim() != models[l]->simTimeline()->size() - 1)
+      throw runtime_error(
+          "mcSimulMLMC() : model does not expose a one-factor timeline");
+  }
+
+  //  Coupling maps: fine step -> coarse step, and the
+  //      renormalization of the aggregated increments per coarse step
+  //  Fine step i spans (s[i], s[i+1]]: it belongs to the first coarse
+  //      step whose right boundary covers s[i+1]
+  vector<vector<size_t>> fineToCoarse(nLevels);
+  vector<vector<double>> coarseNorms(nLevels);
+  for (size_t l = 1; l < nLevels; ++l) {
+    const vector<Time> &fine = *models[l]->simTimeline();
+    const vector<Time> &coarse = *models[l - 1]->simTimeline();
+    const size_t nf = fine.size() - 1, nc = coarse.size() - 1;
+
+    fineToCoarse[l].resize(nf);
+    vector<double> vars(nc, 0.0);
+    for (size_t i = 0; i < nf; ++i) {
+      const size_t j =
+          min<size_t>(nc - 1,
+                      distance(coarse.begin(),
+                               lower_bound(coarse.begin(), coarse.end(),
+                                           fine[i + 1] - 1.0e-10)) -
+                          1);
+      fineToCoarse[l][i] = j;
+      vars[j] += fine[i + 1] - fine[i];
+    }
+    coarseNorms[l].resize(nc);
+    for (size_t j = 0; j < nc; ++j)
+      coarseNorms[l][j] = vars[j] > 0.0 ? 1.0 / sqrt(vars[j]) : 0.0;
+  }
+
+  //  One RNG per level, positioned on disjoint substreams:
+  //      the 32 bit skipTo range is split evenly between the levels,
+  //      and sampling checks a level never outgrows its substream
+  //      (the epsilon pass can push the coarse levels into many
+  //      millions of paths)
+  const size_t levelSpacing = size_t((1ull << 32) / nLevels);
+  vector<unique_ptr<RNG>> rngs(nLevels);
+  for (size_t l = 0; l < nLevels; ++l) {
+    rngs[l] = rng.clone();
+    rngs[l]->init(models[l]->simDim());
+    rngs[l]->skipTo(unsigned(l * levelSpacing));
+  }
+
+  //  Workspace
+  const size_t nPay = prd.payoffLabels().size();
+  vector<double> fineGauss, coarseGauss, payoffs(nPay);
+  Scenario<double> finePath, coarsePath;
+  allocatePath(prd.defline(), finePath);
+  initializePath(finePath);
+  allocatePath(prd.defline(), coarsePath);
+  initializePath(coarsePath);
+
+  //  Level statistics
+  vector<size_t> nDone(nLevels, 0);
+  vector<double> sums(nLevels, 0.0), sumSquares(nLevels, 0.0);
+
+  //  Sample n more paths of the level estimator
+  auto sample = [&](const size_t l, const size_t n) {
+    //  Never run into the next level's substream
+    if (nDone[l] + n > levelSpacing)
+      throw runtime_error(
+          "mcSimulMLMC() : level path allocation exceeds its substream");
+
+    const size_t dimF = models[l]->simDim();
+    fineGauss.resize(dimF);
+
+    for (size_t i = 0; i < n; ++i) {
+      rngs[l]->nextG(fineGauss);
+      models[l]->generatePath(fineGauss, finePath);
+      prd.payoffs(finePath, payoffs);
+      double y = payoffs[0];
+
+      if (l > 0) {
+        //  Aggregate the fine increments over the coarse steps
+        const vector<Time> &fine = *models[l]->simTimeline();
+        const size_t dimC = models[l - 1]->simDim();
+        coarseGauss.assign(dimC, 0.0);
+        for (size_t k = 0; k < dimF; ++k) {
+          coarseGauss[fineToCoarse[l][k]] +=
+              sqrt(fine[k + 1] - fine[k]) * fineGauss[k];
+        }
+        for (size_t j = 0; j < dimC; ++j)
+          coarseGauss[j] *= coarseNorms[l][j];
+
+        models[l - 1]->generatePath(coarseGauss, coarsePath);
+        prd.payoffs(coarsePath, payoffs);
+        y -= payoffs[0];
+      }
+
+      sums[l] += y;
+      sumSquares[l] += y * y;
+    }
+    nDone[l] += n;
+  };
+
+  //  First pass
+  for (size_t l = 0; l < nLevels; ++l)
+    sample(l, initPaths);
+
+  //  Giles' path allocation toward the target standard error:
+  //      Nl ~ sqrt(Vl / Cl) * sum sqrt(Vl Cl) / eps^2,
+  //      with cost Cl taken as the level's number of steps
+  if (epsilon > 0.0) {
+    vector<double> vl(nLevels), cl(nLevels);
+    double sumSqrtVC = 0.0;
+    for (size_t l = 0; l < nLevels; ++l) {
+      const double m = sums[l] / nDone[l];
+      vl[l] = max(sumSquares[l] / nDone[l] - m * m, 1.0e-12);
+      cl[l] = double(models[l]->simDim() +
+                     (l > 0 ? models[l - 1]->simDim() : 0));
+      sumSqrtVC += sqrt(vl[l] * cl[l]);
+    }
+    for (size_t l = 0; l < nLevels; ++l) {
+      const size_t target =
+          size_t(sqrt(vl[l] / cl[l]) * sumSqrtVC / (epsilon * epsilon)) + 1;
+      if (target > nDone[l])
+        sample(l, target - nDone[l]);
+    }
+  }
+
+  //  Combine the levels
+  MLMCResults results;
+  results.value = 0.0;
+  results.stdErr = 0.0;
+  results.levels.resize(nLevels);
+  for (size_t l = 0; l < nLevels; ++l) {
+    const double m = sums[l] / nDone[l];
+    const double v = max(sumSquares[l] / nDone[l] - m * m, 0.0);
+    results.levels[l] = {nDone[l], m, v};
+    results.value += m;
+    results.stdErr += v / nDone[l];
+  }
+  results.stdErr = sqrt(results.stdErr);
+
+  return results;
+}
+
+//  Early exit valuation for knock-out products
+//  Requires a segment capable model (see Model::generateSegment):
+//      the path advances one event date at a time and stops as soon
+//      as the product reports the payoff fully determined,
+//      skipping the simulation of the dead tail
+//  Samples beyond the termination event keep their previous content;
+//      products that opt in guarantee those carry no weight
+inline vector<vector<double>> mcSimulEarlyExit(const Product<double> &prd,
+                                               const Model<double> &mdl,
+                                               const RNG &rng,
+                                               const size_t nPath) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+  if (!mdl.supportsSegments())
+    throw runtime_error(
+        "mcSimulEarlyExit() : model does not support segments");
+  if (!prd.supportsEarlyExit())
+    throw runtime_error(
+        "mcSimulEarlyExit() : product does not support early exit");
+
+  auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  const size_t nPay = prd.payoffLabels().size();
+  vector<vector<double>> results(nPath, vector<double>(nPay));
+
+  cMdl->allocate(prd.timeline(), prd.defline());
+  cMdl->init(prd.timeline(), prd.defline());
+  cRng->init(cMdl->simDim());
+  vector<double> gaussVec(cMdl->simDim());
+  Scenario<double> path;
+  allocatePath(prd.defline(), path);
+  initializePath(path);
+
+  vector<double> state0;
+  cMdl->initState(state0);
+  vector<double> state;
+
+  const size_t nEvents = prd.timeline().size();
+
+  for (size_t i = 0; i < nPath; i++) {
+    cRng->nextG(gaussVec);
+
+    //  Advance event by event, stop when the payoff is determined
+    state = state0;
+    for (size_t e = 0; e < nEvents; ++e) {
+      cMdl->generateSegment(gaussVec, path, state, e, e + 1);
+      if (e + 1 < nEvents && prd.terminated(path, e))
+        break;
+    }
+
+    prd.payoffs(path, results[i]);
+  }
+
+  return results;
+}
+
+//  Streaming valuation
+//  ===================
+
+//  Accumulator for the streaming engines below:
+//      running sum and sum of squares per payoff,
+//      O(nPay) memory instead of the nPath x nPay results matrix
+//  Mergeable, so each thread accumulates its own partial
+//  Any type with the same interface may be passed
+//      to the streaming engines instead
+struct SimulAccumulator {
+  vector<double> sums;
+  vector<double> sumSquares;
+  size_t paths = 0;
+
+  void init(const size_t nPay) {
+    sums.assign(nPay, 0.0);
+    sumSquares.assign(nPay, 0.0);
+    paths = 0;
+  }
+
+  //  One path's payoffs
+  void accumulate(const vector<double> &payoffs) {
+    const size_t n = sums.size();
+    for (size_t j = 0; j < n; ++j) {
+      sums[j] += payoffs[j];
+      sumSquares[j] += payoffs[j] * payoffs[j];
+    }
+    ++paths;
+  }
+
+  //  Merge another thread's partial
+  void merge(const SimulAccumulator &rhs) {
+    const size_t n = sums.size();
+    for (size_t j = 0; j < n; ++j) {
+      sums[j] += rhs.sums[j];
+      sumSquares[j] += rhs.sumSquares[j];
+    }
+    paths += rhs.paths;
+  }
+
+  //  Estimates
+  double mean(const size_t j) const { return sums[j] / paths; }
+  double stdErr(const size_t j) const {
+    const double m = mean(j);
+    return sqrt((sumSquares[j] / paths - m * m) / paths);
+  }
+};
+
+//  Streaming equivalent of mcSimul():
+//      per-path payoffs go straight into the accumulator,
+//      nothing is stored per path
+template <class ACC>
+inline void mcSimulStream(const Product<double> &prd, const Model<double> &mdl,
+                          const RNG &rng, const size_t nPath, ACC &acc) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+
+  auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  const size_t nPay = prd.payoffLabels().size();
+  acc.init(nPay);
+
+  cMdl->allocate(prd.timeline(), prd.defline());
+  cMdl->init(prd.timeline(), prd.defline());
+  cRng->init(cMdl->simDim());
+  vector<double> gaussVec(cMdl->simDim());
+  vector<double> payoffs(nPay);
   Scenario<double> path;
   allocatePath(prd.defline(), path);
   initializePath(path);
 
-  //	Iterate through paths
   for (size_t i = 0; i < nPath; i++) {
-    //  Next Gaussian vector, dimension D
     cRng->nextG(gaussVec);
-    //  Generate path, consume Gaussian vector
-    cMdl->generatePath(gaussVec, path);
-    //	Compute result
-    prd.payoffs(path, results[i]);
+    cMdl->generatePath(gaussVec, path);
+    prd.payoffs(path, payoffs);
+    acc.accumulate(payoffs);
+  }
+}
+
+//  Streaming equivalent of mcParallelSimul():
+//      one accumulator partial per thread, merged at the end
+template <class ACC>
+inline void mcParallelSimulStream(const Product<double> &prd,
+                                  const Model<double> &mdl, const RNG &rng,
+                                  const size_t nPath, ACC &acc,
+                                  //  0 = adaptive batch size
+                                  const size_t batchSizeHint = 0) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+
+  auto cMdl = mdl.clone();
+
+  const size_t nPay = prd.payoffLabels().size();
+
+  cMdl->allocate(prd.timeline(), prd.defline());
+  cMdl->init(prd.timeline(), prd.defline());
+
+  ThreadPool *pool = ThreadPool::getInstance();
+  const size_t nThread = pool->numThreads();
+  vector<matrix<double>> gaussMats(nThread + 1); //  +1 for main
+  vector<vector<Scenario<double>>> pathBlocks(nThread + 1);
+  vector<vector<double>> payoffVecs(nThread + 1);
+
+  //  One accumulator partial per thread
+  vector<ACC> partials(nThread + 1);
+  for (auto &partial : partials)
+    partial.init(nPay);
+
+  //  Workspace allocated?
+  vector<int> wsInit(nThread + 1, false);
+
+  //  One RNG per thread
+  vector<unique_ptr<RNG>> rngs(nThread + 1);
+  for (auto &random : rngs) {
+    random = rng.clone();
+    random->init(cMdl->simDim());
+  }
+
+  //  The work for one batch of paths
+  auto simulateBatch = [&](const size_t firstPath, const size_t pathsInTask) {
+    //  This thread's workspace, first touch on first use
+    const size_t threadNum = pool->threadNum();
+    if (!wsInit[threadNum]) {
+      gaussMats[threadNum].resize(PATHBLOCK, cMdl->simDim());
+      pathBlocks[threadNum].resize(PATHBLOCK);
+      for (auto &path : pathBlocks[threadNum]) {
+        allocatePath(prd.defline(), path);
+        initializePath(path);
+      }
+      payoffVecs[threadNum].resize(nPay);
+      wsInit[threadNum] = true;
+    }
+    matrix<double> &gaussMat = gaussMats[threadNum];
+    vector<Scenario<double>> &block = pathBlocks[threadNum];
+    vector<double> &payoffs = payoffVecs[threadNum];
+
+    Scenario<double> *pathPtrs[PATHBLOCK];
+    for (size_t k = 0; k < PATHBLOCK; ++k)
+      pathPtrs[k] = &block[k];
+
+    auto &random = rngs[threadNum];
+    random->skipTo(firstPath);
+
+    size_t done = 0;
+    while (done < pathsInTask) {
+      const size_t nb = min(PATHBLOCK, pathsInTask - done);
+
+      random->nextGBlock(gaussMat, nb);
+      cMdl->generatePaths(gaussMat, pathPtrs, nb);
+      for (size_t k = 0; k < nb; ++k) {
+        prd.payoffs(block[k], payoffs);
+        partials[threadNum].accumulate(payoffs);
+      }
+
+      done += nb;
+    }
+  };
+
+  //  Calibration batch, see mcParallelSimul
+  const size_t calibPaths = min<size_t>(nPath, MINBATCH);
+  const auto calibStart = chrono::high_resolution_clock::now();
+  simulateBatch(0, calibPaths);
+  const double calibMicros =
+      chrono::duration<double, micro>(chrono::high_resolution_clock::now() -
+                                      calibStart)
+          .count();
+  const size_t batchSize =
+      adaptiveBatchSize(nPath, nThread, calibPaths, calibMicros, batchSizeHint);
+
+  TaskGroup batches;
+
+  size_t firstPath = calibPaths;
+  size_t pathsLeft = nPath - calibPaths;
+  while (pathsLeft > 0) {
+    size_t pathsInTask = min<size_t>(pathsLeft, batchSize);
+
+    pool->spawnTask(batches, [&, firstPath, pathsInTask]() {
+      simulateBatch(firstPath, pathsInTask);
+    });
+
+    pathsLeft -= pathsInTask;
+    firstPath += pathsInTask;
+  }
+
+  pool->activeWait(batches);
+
+  //  Merge the partials into the caller's accumulator
+  acc.init(nPay);
+  for (const auto &partial : partials)
+    acc.merge(partial);
+}
+
+//  AAD instrumentation of mcSimul(), chapter 12
+
+//  returns the following results:
+struct AADSimulResults {
+  AADSimulResults(const size_t nPath, const size_t nPay, const size_t nParam)
+      : payoffs(nPath, vector<double>(nPay)), aggregated(nPath), risks(nParam) {
+  }
+
+  //  matrix(0..nPath - 1, 0..nPay - 1) of payoffs, same as mcSimul()
+  vector<vector<double>> payoffs;
+
+  //  vector(0..nPath) of aggregated payoffs
+  vector<double> aggregated;
+
+  //  vector(0..nParam - 1) of risk sensitivities
+  //  of aggregated payoff, averaged over paths
+  vector<double> risks;
+};
+
+//  Default aggregator = 1st payoff = payoff[0]
+const auto defaultAggregator = [](const vector<Number> &v) { return v[0]; };
+
+//  Record one dry path after the mark, measure its tape footprint,
+//      rewind, and pre-reserve the tape so the path loop
+//      never hits the system allocator mid-path
+//  The dry path consumes a clone of the (freshly initialized) RNG,
+//      so the caller's sequence is untouched
+//  Returns the reserved footprint so parallel engines can apply it
+//      to the worker tapes
+inline Tape::Footprint reserveTapeFromDryRun(const Product<Number> &prd,
+                                             const Model<Number> &mdl,
+                                             const RNG &rng,
+                                             Scenario<Number> &path,
+                                             vector<Number> &payoffs) {
+  Tape &tape = *Number::tape;
+  const auto before = tape.used();
+
+  auto dryRng = rng.clone();
+  static thread_local vector<double> gaussVec;
+  gaussVec.resize(mdl.simDim());
+  dryRng->nextG(gaussVec);
+  mdl.generatePath(gaussVec, path);
+  prd.payoffs(path, payoffs);
+
+  const auto after = tape.used();
+  tape.rewindToMark();
+
+  //  Safety margin of half a path on top:
+  //      payoffs that branch may record more on other paths
+  const Tape::Footprint need{after.nodes + (after.nodes - before.nodes) / 2,
+                             after.ders + (after.ders - before.ders) / 2,
+                             after.adjoints +
+                                 (after.adjoints - before.adjoints) / 2};
+  tape.reserve(need);
+
+  return need;
+}
+
+template <class F = decltype(defaultAggregator)>
+inline AADSimulResults
+mcSimulAAD(const Product<Number> &prd, const Model<Number> &mdl, const RNG &rng,
+           const size_t nPath, const F &aggFun = defaultAggregator) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+
+  //  Work with copies of the model and RNG
+  //      which are modified when we set up the simulation
+  //  Copies are OK at high level
+  auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  //  Allocate path and model
+  Scenario<Number> path;
+  allocatePath(prd.defline(), path);
+  cMdl->allocate(prd.timeline(), prd.defline());
+
+  //  Dimensions
+  const size_t nPay = prd.payoffLabels().size();
+  const vector<Number *> &params = cMdl->parameters();
+  const size_t nParam = params.size();
+
+  //  AAD - 1
+  //  Access to tape
+  Tape &tape = *Number::tape;
+  //  Clear and initialise tape
+  tape.clear();
+  auto resetter = setNumResultsForAAD();
+  {
+    MCPROFILE_SCOPE(mcPhaseSetup);
+    //  Put parameters on tape
+    //  note that also initializes all adjoints
+    putModelParametersOnTape(cMdl);
+    //  Init the simulation timeline
+    //  CAREFUL: simulation timeline must be on tape
+    //  Hence moved here
+    cMdl->init(prd.timeline(), prd.defline());
+    //  Initialize path
+    initializePath(path);
+    //  Mark the tape straight after initialization
+    tape.mark();
+  }
+  //
+
+  //  Init the RNG
+  cRng->init(cMdl->simDim());
+
+  //  Allocate workspace
+  vector<Number> nPayoffs(nPay);
+  //  Gaussian vector
+  vector<double> gaussVec(cMdl->simDim());
+
+  //  Dry run: pre-reserve the tape to one path's footprint
+  reserveTapeFromDryRun(prd, *cMdl, *cRng, path, nPayoffs);
+
+  //  Results
+  AADSimulResults results(nPath, nPay, nParam);
+
+  //	Iterate through paths
+  for (size_t i = 0; i < nPath; i++) {
+    //  AAD - 2
+    //  Rewind tape to mark
+    //  parameters stay on tape but the rest is wiped
+    tape.rewindToMark();
+    //
+
+    //  Next Gaussian vector, dimension D
+    {
+      MCPROFILE_SCOPE(mcPhaseRng);
+      cRng->nextG(gaussVec);
+    }
+    //  Generate path, consume Gaussian vector
+    {
+      MCPROFILE_SCOPE(mcPhasePath);
+      cMdl->generatePath(gaussVec, path);
+    }
+    //	Compute result
+    {
+      MCPROFILE_SCOPE(mcPhasePayoffs);
+      prd.payoffs(path, nPayoffs);
+    }
+    //  Aggregate
+    Number result = aggFun(nPayoffs);
+
+    //  AAD - 3
+    //  Propagate adjoints
+    {
+      MCPROFILE_SCOPE(mcPhasePropagate);
+      result.propagateToMark();
+    }
+    //  Store results for the path
+    results.aggregated[i] = double(result);
+    convertCollection(nPayoffs.begin(), nPayoffs.end(),
+                      results.payoffs[i].begin());
+    //
+  }
+
+  //  AAD - 4
+  //  Mark = limit between pre-calculations and path-wise operations
+  //  Operations above mark have been propagated and accumulated
+  //  We conduct one propagation mark to start
+  {
+    MCPROFILE_SCOPE(mcPhaseFinal);
+    Number::propagateMarkToStart();
+  }
+  //
+
+  //  Pick sensitivities, summed over paths, and normalize
+  transform(params.begin(), params.end(), results.risks.begin(),
+            [nPath](const Number *p) { return p->adjoint() / nPath; });
+
+  //  Clear the tape
+  tape.clear();
+
+  return results;
+}
+
+//  AAD with a static payoff kernel, chapter 15 machinery
+//  The product evaluates its payoff record-free: the expression's
+//      adjoints accumulate straight into the samples' nodes
+//      (Number::accumulateAdjoints), so the tape carries only the
+//      model section and the backward sweep never visits a payoff node
+template <class PRD>
+inline AADSimulResults mcSimulAADStatic(const PRD &prd,
+                                        const Model<Number> &mdl,
+                                        const RNG &rng, const size_t nPath) {
+  if (!checkCompatiblity(prd, mdl))
+    throw runtime_error("Model and product are not compatible");
+  if (!prd.supportsStaticPayoff())
+    throw runtime_error(
+        "mcSimulAADStatic() : product has no static payoff kernel");
+
+  auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  Scenario<Number> path;
+  allocatePath(prd.defline(), path);
+  cMdl->allocate(prd.timeline(), prd.defline());
+
+  const vector<Number *> &params = cMdl->parameters();
+  const size_t nParam = params.size();
+
+  Tape &tape = *Number::tape;
+  tape.clear();
+  auto resetter = setNumResultsForAAD();
+  putModelParametersOnTape(cMdl);
+  cMdl->init(prd.timeline(), prd.defline());
+  initializePath(path);
+  tape.mark();
+
+  cRng->init(cMdl->simDim());
+
+  vector<double> gaussVec(cMdl->simDim());
+
+  AADSimulResults results(nPath, 1, nParam);
+
+  for (size_t i = 0; i < nPath; i++) {
+    tape.rewindToMark();
+
+    cRng->nextG(gaussVec);
+    cMdl->generatePath(gaussVec, path);
+
+    //  Payoff value and sample adjoints, nothing recorded
+    const double result = prd.staticPayoff(path);
+
+    //  Backward sweep over the model section only
+    Number::propagateAdjoints(prev(tape.end()), tape.markIt());
+
+    results.aggregated[i] = result;
+    results.payoffs[i][0] = result;
+  }
+
+  Number::propagateMarkToStart();
+
+  transform(params.begin(), params.end(), results.risks.begin(),
+            [nPath](const Number *p) { return p->adjoint() / nPath; });
+
+  tape.clear();
+
+  return results;
+}
+
+//  Hybrid AAD: analytic pathwise adjoints for the model section,
+//      tape for the payoff only
+//  The path is generated by the plain double model (storing its
+//      backward workspace), its samples enter the tape as leaves,
+//      the payoff propagates to those leaves as usual, and the model
+//      pushes the leaf adjoints into its parameter adjoints in
+//      closed form - the O(timeline) model section never touches
+//      the tape, cutting both memory and propagation severalfold
+template <class F = decltype(defaultAggregator)>
+inline AADSimulResults
+mcSimulAADHybrid(const Product<Number> &prd, const Model<double> &mdl,
+                 const RNG &rng, const size_t nPath,
+                 const F &aggFun = defaultAggregator) {
+  if (prd.assetNames() != mdl.assetNames())
+    throw runtime_error("Model and product are not compatible");
+  if (!mdl.supportsPathAdjoints())
+    throw runtime_error(
+        "mcSimulAADHybrid() : model has no pathwise adjoint kernel");
+
+  auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  cMdl->allocate(prd.timeline(), prd.defline());
+  cMdl->init(prd.timeline(), prd.defline());
+
+  const size_t nPay = prd.payoffLabels().size();
+  const size_t nParam = cMdl->numParams();
+
+  //  The double path and its adjoints, and the payoff's Number path
+  Scenario<double> dPath, adjPath;
+  allocatePath(prd.defline(), dPath);
+  initializePath(dPath);
+  allocatePath(prd.defline(), adjPath);
+  Scenario<Number> path;
+  allocatePath(prd.defline(), path);
+
+  //  The tape carries the payoff only: no parameters on it
+  Tape &tape = *Number::tape;
+  tape.clear();
+  auto resetter = setNumResultsForAAD();
+  initializePath(path);
+  tape.mark();
+
+  cRng->init(cMdl->simDim());
+  vector<double> gaussVec(cMdl->simDim());
+  vector<Number> nPayoffs(nPay);
+
+  //  Parameter adjoints, accumulated analytically
+  vector<double> paramAdj(nParam, 0.0);
+
+  AADSimulResults results(nPath, nPay, nParam);
+
+  const size_t nEvents = prd.timeline().size();
+
+  for (size_t i = 0; i < nPath; i++) {
+    cRng->nextG(gaussVec);
+
+    //  Model section: plain double, off tape
+    cMdl->generatePathStoring(gaussVec, dPath);
+
+    //  The samples enter the payoff tape as leaves
+    tape.rewindToMark();
+    for (size_t e = 0; e < nEvents; ++e) {
+      const Sample<double> &src = dPath[e];
+      Sample<Number> &dst = path[e];
+      dst.numeraire = Number(src.numeraire);
+      for (size_t k = 0; k < src.discounts.size(); ++k)
+        dst.discounts[k] = Number(src.discounts[k]);
+      for (size_t k = 0; k < src.libors.size(); ++k)
+        dst.libors[k] = Number(src.libors[k]);
+      for (size_t a = 0; a < src.forwards.size(); ++a)
+        for (size_t k = 0; k < src.forwards[a].size(); ++k)
+          dst.forwards[a][k] = Number(src.forwards[a][k]);
+    }
+
+    //  Payoff on tape, propagate to the sample leaves
+    prd.payoffs(path, nPayoffs);
+    Number result = aggFun(nPayoffs);
+    result.propagateToMark();
+
+    //  Collect the sample adjoints
+    for (size_t e = 0; e < nEvents; ++e) {
+      const Sample<Number> &src = path[e];
+      Sample<double> &dst = adjPath[e];
+      dst.numeraire = src.numeraire.adjoint();
+      for (size_t k = 0; k < src.discounts.size(); ++k)
+        dst.discounts[k] = src.discounts[k].adjoint();
+      for (size_t k = 0; k < src.libors.size(); ++k)
+        dst.libors[k] = src.libors[k].adjoint();
+      for (size_t a = 0; a < src.forwards.size(); ++a)
+        for (size_t k = 0; k < src.forwards[a].size(); ++k)
+          dst.forwards[a][k] = src.forwards[a][k].adjoint();
+    }
+
+    //  Model section backward, in closed form
+    cMdl->propagatePathAdjoints(adjPath, paramAdj);
+
+    results.aggregated[i] = double(result);
+    convertCollection(nPayoffs.begin(), nPayoffs.end(),
+                      results.payoffs[i].begin());
   }
 
-  return results; //	C++11: move
-}
+  transform(paramAdj.begin(), paramAdj.end(), results.risks.begin(),
+            [nPath](const double a) { return a / nPath; });
 
-//  Parallel valuation, chapter 7
+  tape.clear();
 
-#define BATCHSIZE                                                              \
-  size_t { 64 }
-//	Parallel equivalent of mcSimul()
-inline vector<vector<double>> mcParallelSimul(const Product<double> &prd,
-                                              const Model<double> &mdl,
-                                              const RNG &rng,
-                                              const size_t nPath) {
+  return results;
+}
+
+//  Record once / replay many, chapter 12 engine
+//      over the compact frozen stream of AADCompact.h
+//  For structurally fixed paths the wiring of the backward pass is
+//      captured once: subsequent paths only refresh the derivatives
+//      (a sequential copy) and sweep the compact image, instead of
+//      re-resolving per-node pointer chains on the live tape.
+//  Paths that record a different structure (branching payoffs)
+//      rebuild the image transparently, so results are always exact.
+template <class F = decltype(defaultAggregator)>
+inline AADSimulResults
+mcSimulAADReplay(const Product<Number> &prd, const Model<Number> &mdl,
+                 const RNG &rng, const size_t nPath,
+                 const F &aggFun = defaultAggregator) {
   if (!checkCompatiblity(prd, mdl))
     throw runtime_error("Model and product are not compatible");
 
   auto cMdl = mdl.clone();
+  auto cRng = rng.clone();
+
+  Scenario<Number> path;
+  allocatePath(prd.defline(), path);
+  cMdl->allocate(prd.timeline(), prd.defline());
 
   const size_t nPay = prd.payoffLabels().size();
-  vector<vector<double>> results(nPath, vector<double>(nPay));
+  const vector<Number *> &params = cMdl->parameters();
+  const size_t nParam = params.size();
 
-  cMdl->allocate(prd.timeline(), prd.defline());
+  Tape &tape = *Number::tape;
+  tape.clear();
+  auto resetter = setNumResultsForAAD();
+  putModelParametersOnTape(cMdl);
   cMdl->init(prd.timeline(), prd.defline());
+  initializePath(path);
+  tape.mark();
 
-  //  Allocate space for Gaussian vectors and paths,
-  //      one for each thread
-  ThreadPool *pool = ThreadPool::getInstance();
-  const size_t nThread = pool->numThreads();
-  vector<vector<double>> gaussVecs(nThread + 1); //  +1 for main
-  vector<Scenario<double>> paths(nThread + 1);
-  for (auto &vec : gaussVecs)
-    vec.resize(cMdl->simDim());
-  for (auto &path : paths) {
-    allocatePath(prd.defline(), path);
-    initializePath(path);
-  }
-
-  //  One RNG per thread
-  vector<unique_ptr<RNG>> rngs(nThread + 1);
-  for (auto &random : rngs) {
-    random = rng.clone();
-    random->init(cMdl->simDim());
-  }
+  cRng->init(cMdl->simDim());
 
-  //  Reserve memory for futures
-  vector<TaskHandle> futures;
-  futures.reserve(nPath / BATCHSIZE + 1);
+  vector<Number> nPayoffs(nPay);
+  vector<double> gaussVec(cMdl->simDim());
 
-  //  Start
-  //  Same as mcSimul() except we send tasks to the pool
-  //  instead of executing them
+  //  Dry run: pre-reserve the tape to one path's footprint
+  reserveTapeFromDryRun(prd, *cMdl, *cRng, path, nPayoffs);
 
-  size_t firstPath = 0;
-  size_t pathsLeft = nPath;
-  while (pathsLeft > 0) {
-    size_t pathsInTask = min<size_t>(pathsLeft, BATCHSIZE);
-
-    futures.push_back(pool->spawnTask([&, firstPath, pathsInTask]() {
-      //  Inside the parallel task,
-      //      pick the right pre-allocated vectors
-      const size_t threadNum = pool->threadNum();
-      vector<double> &gaussVec = gaussVecs[threadNum];
-      Scenario<double> &path = paths[threadNum];
-
-      //  Get a RNG and position it correctly
-      auto &random = rngs[threadNum];
-      random->skipTo(firstPath);
-
-      //  And conduct the simulations, exactly same as sequential
-      for (size_t i = 0; i < pathsInTask; i++) {
-        //  Next Gaussian vector, dimension D
-        random->nextG(gaussVec);
-        //  Path
-        cMdl->generatePath(gaussVec, path);
-        //  Payoff
-        prd.payoffs(path, results[firstPath + i]);
-      }
+  AADSimulResults results(nPath, nPay, nParam);
 
-      //  Remember tasks must return bool
-      return true;
-    }));
+  //  The frozen image of the path-wise tape region
+  CompactTape compact;
+  bool built = false;
 
-    pathsLeft -= pathsInTask;
-    firstPath += pathsInTask;
-  }
+  for (size_t i = 0; i < nPath; i++) {
+    tape.rewindToMark();
 
-  //  Wait and help
-  for (auto &future : futures)
-    pool->activeWait(future);
+    cRng->nextG(gaussVec);
+    cMdl->generatePath(gaussVec, path);
+    prd.payoffs(path, nPayoffs);
+    Number result = aggFun(nPayoffs);
 
-  return results; //	C++11: move
-}
+    //  Fused backward sweep over the frozen stream,
+    //      rebuild and sweep the slow way on any structural change
+    bool swept = false;
+    if (built) {
+      compact.resetAdjoints();
+      if (double *seed = compact.findAdjoint(&result.adjoint())) {
+        *seed = 1.0;
+        swept = compact.propagateFused(tape.markIt(), tape.end());
+      }
+    }
+    if (!swept) {
+      compact.build(tape.markIt(), tape.end());
+      built = true;
+      compact.resetAdjoints();
+      compact.adjoint(&result.adjoint()) = 1.0;
+      compact.propagate();
+    }
 
-//  AAD instrumentation of mcSimul(), chapter 12
+    //  External slots accumulate below the mark
+    compact.flushExternal();
 
-//  returns the following results:
-struct AADSimulResults {
-  AADSimulResults(const size_t nPath, const size_t nPay, const size_t nParam)
-      : payoffs(nPath, vector<double>(nPay)), aggregated(nPath), risks(nParam) {
+    results.aggregated[i] = double(result);
+    convertCollection(nPayoffs.begin(), nPayoffs.end(),
+                      results.payoffs[i].begin());
   }
 
-  //  matrix(0..nPath - 1, 0..nPay - 1) of payoffs, same as mcSimul()
-  vector<vector<double>> payoffs;
+  //  One propagation of the accumulated adjoints, mark to start
+  Number::propagateMarkToStart();
 
-  //  vector(0..nPath) of aggregated payoffs
-  vector<double> aggregated;
+  transform(params.begin(), params.end(), results.risks.begin(),
+            [nPath](const Number *p) { return p->adjoint() / nPath; });
 
-  //  vector(0..nParam - 1) of risk sensitivities
-  //  of aggregated payoff, averaged over paths
-  vector<double> risks;
-};
+  tape.clear();
 
-//  Default aggregator = 1st payoff = payoff[0]
-const auto defaultAggregator = [](const vector<Number> &v) { return v[0]; };
+  return results;
+}
 
+//  Checkpointed AAD for long timelines
+//  The tape only ever holds one segment of the timeline:
+//      the full path is first advanced segment by segment with the
+//      plain double model, storing the diffusion state at segment
+//      boundaries, then the segments are recorded and propagated
+//      backwards one at a time, with the state adjoints chained
+//      across the boundaries and the samples of the other segments
+//      held as constants (their contributions are picked up when
+//      their own segment is swept, differentiation being linear)
+//  Tape memory drops from O(timeline) recorded operations to
+//      O(segment) operations plus O(timeline) bare constant leaves
+//      (no derivatives, no arguments - a small fraction of a
+//      recorded step); payoffs are evaluated once per segment per path
 template <class F = decltype(defaultAggregator)>
-inline AADSimulResults
-mcSimulAAD(const Product<Number> &prd, const Model<Number> &mdl, const RNG &rng,
-           const size_t nPath, const F &aggFun = defaultAggregator) {
+inline AADSimulResults mcSimulAADCheckpoint(
+    const Product<Number> &prd,
+    //  Instrumented model, records the segments
+    const Model<Number> &mdl,
+    //  Plain model, advances the forward path off tape
+    const Model<double> &fwdMdl, const RNG &rng, const size_t nPath,
+    //  Segment length, in event dates
+    const size_t eventsPerSegment, const F &aggFun = defaultAggregator) {
   if (!checkCompatiblity(prd, mdl))
     throw runtime_error("Model and product are not compatible");
+  if (!mdl.supportsSegments() || !fwdMdl.supportsSegments())
+    throw runtime_error(
+        "mcSimulAADCheckpoint() : model does not support segments");
 
-  //  Work with copies of the model and RNG
-  //      which are modified when we set up the simulation
-  //  Copies are OK at high level
   auto cMdl = mdl.clone();
+  auto cFwd = fwdMdl.clone();
   auto cRng = rng.clone();
 
-  //  Allocate path and model
   Scenario<Number> path;
   allocatePath(prd.defline(), path);
+  Scenario<double> fwdPath;
+  allocatePath(prd.defline(), fwdPath);
+  initializePath(fwdPath);
   cMdl->allocate(prd.timeline(), prd.defline());
+  cFwd->allocate(prd.timeline(), prd.defline());
+  cFwd->init(prd.timeline(), prd.defline());
 
-  //  Dimensions
   const size_t nPay = prd.payoffLabels().size();
   const vector<Number *> &params = cMdl->parameters();
   const size_t nParam = params.size();
 
-  //  AAD - 1
-  //  Access to tape
   Tape &tape = *Number::tape;
-  //  Clear and initialise tape
   tape.clear();
   auto resetter = setNumResultsForAAD();
-  //  Put parameters on tape
-  //  note that also initializes all adjoints
   putModelParametersOnTape(cMdl);
-  //  Init the simulation timeline
-  //  CAREFUL: simulation timeline must be on tape
-  //  Hence moved here
   cMdl->init(prd.timeline(), prd.defline());
-  //  Initialize path
   initializePath(path);
-  //  Mark the tape straight after initialization
   tape.mark();
-  //
 
-  //  Init the RNG
   cRng->init(cMdl->simDim());
 
-  //  Allocate workspace
   vector<Number> nPayoffs(nPay);
-  //  Gaussian vector
   vector<double> gaussVec(cMdl->simDim());
 
-  //  Results
+  //  Segment boundaries over the event dates
+  const size_t nEvents = prd.timeline().size();
+  vector<size_t> bounds;
+  for (size_t e = 0; e < nEvents; e += eventsPerSegment)
+    bounds.push_back(e);
+  bounds.push_back(nEvents);
+  const size_t nSeg = bounds.size() - 1;
+
+  //  Diffusion states at the segment boundaries
+  vector<double> state0;
+  cFwd->initState(state0);
+  const size_t nState = state0.size();
+  vector<vector<double>> states(nSeg + 1);
+
+  //  State adjoints chained backwards across the boundaries
+  vector<double> stateAdj(nState);
+
   AADSimulResults results(nPath, nPay, nParam);
 
-  //	Iterate through paths
   for (size_t i = 0; i < nPath; i++) {
-    //  AAD - 2
-    //  Rewind tape to mark
-    //  parameters stay on tape but the rest is wiped
-    tape.rewindToMark();
-    //
-
-    //  Next Gaussian vector, dimension D
     cRng->nextG(gaussVec);
-    //  Generate path, consume Gaussian vector
-    cMdl->generatePath(gaussVec, path);
-    //	Compute result
-    prd.payoffs(path, nPayoffs);
-    //  Aggregate
-    Number result = aggFun(nPayoffs);
 
-    //  AAD - 3
-    //  Propagate adjoints
-    result.propagateToMark();
-    //  Store results for the path
-    results.aggregated[i] = double(result);
-    convertCollection(nPayoffs.begin(), nPayoffs.end(),
-                      results.payoffs[i].begin());
-    //
+    //  Forward sweep, off tape: path and boundary states
+    states[0] = state0;
+    for (size_t k = 0; k < nSeg; ++k) {
+      states[k + 1] = states[k];
+      cFwd->generateSegment(gaussVec, fwdPath, states[k + 1], bounds[k],
+                            bounds[k + 1]);
+    }
+
+    //  Backward sweep, one segment's tape at a time
+    fill(stateAdj.begin(), stateAdj.end(), 0.0);
+    for (size_t k = nSeg; k > 0; --k) {
+      const size_t seg = k - 1;
+
+      tape.rewindToMark();
+
+      //  The other segments' samples as constants
+      for (size_t e = 0; e < nEvents; ++e) {
+        if (e >= bounds[seg] && e < bounds[seg + 1])
+          continue;
+        const Sample<double> &src = fwdPath[e];
+        Sample<Number> &dst = path[e];
+        dst.numeraire = Number(src.numeraire);
+        convertCollection(src.discounts.begin(), src.discounts.end(),
+                          dst.discounts.begin());
+        convertCollection(src.libors.begin(), src.libors.end(),
+                          dst.libors.begin());
+        for (size_t a = 0; a < src.forwards.size(); ++a)
+          convertCollection(src.forwards[a].begin(), src.forwards[a].end(),
+                            dst.forwards[a].begin());
+      }
+
+      //  The boundary state on tape
+      vector<Number> stateIn(nState);
+      if (seg == 0) {
+        //  The first boundary state is a function of the parameters
+        //      (the spot): record it through the instrumented model
+        //      so the parameters receive the path's dependence on it
+        cMdl->initState(stateIn);
+      } else {
+        //  Later boundaries enter as leaves, their adjoints
+        //      are chained backwards through stateAdj
+        convertCollection(states[seg].begin(), states[seg].end(),
+                          stateIn.begin());
+      }
+      vector<Number> state = stateIn;
+
+      //  Record the segment and the payoff over it
+      cMdl->generateSegment(gaussVec, path, state, bounds[seg],
+                            bounds[seg + 1]);
+      prd.payoffs(path, nPayoffs);
+      Number result = aggFun(nPayoffs);
+
+      //  Seed: the payoff, and the chained state adjoints
+      //      on this segment's end boundary
+      result.adjoint() = 1.0;
+      for (size_t j = 0; j < nState; ++j)
+        state[j].adjoint() += stateAdj[j];
+
+      //  Propagate the segment, accumulate into parameters
+      //      (below the mark) and into the start boundary state
+      Number::propagateAdjoints(prev(tape.end()), tape.markIt());
+
+      for (size_t j = 0; j < nState; ++j)
+        stateAdj[j] = stateIn[j].adjoint();
+
+      //  Results are picked on the last segment's sweep
+      if (k == nSeg) {
+        results.aggregated[i] = double(result);
+        convertCollection(nPayoffs.begin(), nPayoffs.end(),
+                          results.payoffs[i].begin());
+      }
+    }
   }
 
-  //  AAD - 4
-  //  Mark = limit between pre-calculations and path-wise operations
-  //  Operations above mark have been propagated and accumulated
-  //  We conduct one propagation mark to start
   Number::propagateMarkToStart();
-  //
 
-  //  Pick sensitivities, summed over paths, and normalize
   transform(params.begin(), params.end(), results.risks.begin(),
             [nPath](const Number *p) { return p->adjoint() / nPath; });
 
-  //  Clear the tape
   tape.clear();
 
   return results;
@@ -509,7 +1878,9 @@ template <class F = decltype(defaultAggregator)>
 inline AADSimulResults mcParallelSimulAAD(const Product<Number> &prd,
                                           const Model<Number> &mdl,
                                           const RNG &rng, const size_t nPath,
-                                          const F &aggFun = defaultAggregator) {
+                                          const F &aggFun = defaultAggregator,
+                                          //  0 = adaptive batch size
+                                          const size_t batchSizeHint = 0) {
   if (!checkCompatiblity(prd, mdl))
     throw runtime_error("Model and product are not compatible");
 
@@ -530,139 +1901,190 @@ inline AADSimulResults mcParallelSimulAAD(const Product<Number> &prd,
   ThreadPool *pool = ThreadPool::getInstance();
   const size_t nThread = pool->numThreads();
 
+  //  The engine may itself run on a pool worker (the async tier
+  //      submits whole requests): the "main" role - the tape holding
+  //      the parameters, init and mark recorded above - belongs to
+  //      the INVOKING thread, whichever it is, and every other
+  //      thread gets one of the engine's own tapes
+  const size_t mainThreadNum = pool->threadNum();
+  Tape *const mainTape = Number::tape;
+
   //  Allocate workspace
+  //  The invoking thread's workspace is allocated here,
+  //      the others allocate (first touch) their own on first use
+  //      so tape blocks, Gaussians and scenarios
+  //      stay on the worker's NUMA node
 
   //  One model clone per thread
   vector<unique_ptr<Model<Number>>> models(nThread + 1);
   for (auto &model : models) {
     model = mdl.clone();
-    model->allocate(prd.timeline(), prd.defline());
   }
+  models[mainThreadNum]->allocate(prd.timeline(), prd.defline());
 
   //  One scenario per thread
   vector<Scenario<Number>> paths(nThread + 1);
-  for (auto &path : paths) {
-    allocatePath(prd.defline(), path);
-  }
+  allocatePath(prd.defline(), paths[mainThreadNum]);
 
   //  One vector of payoffs per thread
-  vector<vector<Number>> payoffs(nThread + 1, vector<Number>(nPay));
+  vector<vector<Number>> payoffs(nThread + 1);
+  payoffs[mainThreadNum].resize(nPay);
 
   //  ~workspace
 
-  //  Tapes for the worker threads
-  //  The main thread has one of its own
-  vector<Tape> tapes(nThread);
+  //  Tapes for the other threads, by thread number
+  //      (the invoking thread's entry stays unused)
+  vector<Tape> tapes(nThread + 1);
 
   //  Model initialized?
   //  Note we don't use vector<bool>
   //      because vector<bool> is not thread safe
   vector<int> mdlInit(nThread + 1, false);
 
-  //  Initialize main thread
-  initModel4ParallelAAD(prd, *models[0], paths[0]);
+  //  Initialize the invoking thread
+  initModel4ParallelAAD(prd, *models[mainThreadNum], paths[mainThreadNum]);
 
-  //  Mark main thread as initialized
-  mdlInit[0] = true;
+  //  Mark the invoking thread as initialized
+  mdlInit[mainThreadNum] = true;
 
   //  Init the RNGs, one pet thread
   //  One RNG per thread
   vector<unique_ptr<RNG>> rngs(nThread + 1);
   for (auto &random : rngs) {
     random = rng.clone();
-    random->init(models[0]->simDim());
+    random->init(models[mainThreadNum]->simDim());
   }
 
   //  One Gaussian vector per thread
-  vector<vector<double>> gaussVecs(nThread + 1,
-                                   vector<double>(models[0]->simDim()));
-
-  //  Reserve memory for futures
-  vector<TaskHandle> futures;
-  futures.reserve(nPath / BATCHSIZE + 1);
-
-  //  Start
-  //  Same as mcSimul() except we send tasks to the pool
-  //  instead of executing them
-
-  size_t firstPath = 0;
-  size_t pathsLeft = nPath;
-  while (pathsLeft > 0) {
-    size_t pathsInTask = min<size_t>(pathsLeft, BATCHSIZE);
-
-    futures.push_back(pool->spawnTask([&, firstPath, pathsInTask]() {
-      const size_t threadNum = pool->threadNum();
-
-      //  Use this thread's tape
-      //  Thread local magic: each thread its own pointer
-      //  Note main thread = 0 is not reset
-      if (threadNum > 0)
-        Number::tape = &tapes[threadNum - 1];
-
-      //  Initialize once on each thread
-      if (!mdlInit[threadNum]) {
-        //  Initialize
-        initModel4ParallelAAD(prd, *models[threadNum], paths[threadNum]);
-
-        //  Mark as initialized
-        mdlInit[threadNum] = true;
-      }
+  vector<vector<double>> gaussVecs(nThread + 1);
+  gaussVecs[mainThreadNum].resize(models[mainThreadNum]->simDim());
+
+  //  Dry run on the invoking thread: measure one path's tape
+  //      footprint and pre-reserve; the others apply the same
+  const Tape::Footprint pathFootprint = reserveTapeFromDryRun(
+      prd, *models[mainThreadNum], *rngs[mainThreadNum], paths[mainThreadNum],
+      payoffs[mainThreadNum]);
+
+  //  The work for one batch of paths
+  auto simulateBatch = [&](const size_t firstPath, const size_t pathsInTask) {
+    const size_t threadNum = pool->threadNum();
+
+    //  Use this thread's tape
+    //  Thread local magic: each thread its own pointer
+    //  The invoking thread keeps the request tape,
+    //      wherever the batch actually executes
+    Number::tape = threadNum == mainThreadNum ? mainTape : &tapes[threadNum];
+
+    //  Initialize once on each thread
+    if (!mdlInit[threadNum]) {
+      //  First touch: allocate this thread's workspace
+      //      and recreate its tape's first block locally
+      Number::tape->clear();
+      models[threadNum]->allocate(prd.timeline(), prd.defline());
+      allocatePath(prd.defline(), paths[threadNum]);
+      payoffs[threadNum].resize(nPay);
+      gaussVecs[threadNum].resize(models[threadNum]->simDim());
+
+      //  Initialize
+      initModel4ParallelAAD(prd, *models[threadNum], paths[threadNum]);
+      //  Pre-reserve this thread's tape to the measured footprint
+      Number::tape->reserve(pathFootprint);
+
+      //  Mark as initialized
+      mdlInit[threadNum] = true;
+    }
 
-      //  Get a RNG and position it correctly
-      auto &random = rngs[threadNum];
-      random->skipTo(firstPath);
+    //  Get a RNG and position it correctly
+    auto &random = rngs[threadNum];
+    random->skipTo(firstPath);
 
-      //  And conduct the simulations, exactly same as sequential
-      for (size_t i = 0; i < pathsInTask; i++) {
-        //  Rewind tape to mark
-        //  Notice : this is the tape for the executing thread
+    //  And conduct the simulations, exactly same as sequential
+    for (size_t i = 0; i < pathsInTask; i++) {
+      //  Rewind tape to mark
+      //  Notice : this is the tape for the executing thread
 
-        Number::tape->rewindToMark();
-        //  Next Gaussian vector, dimension D
+      Number::tape->rewindToMark();
+      //  Next Gaussian vector, dimension D
+      {
+        MCPROFILE_SCOPE(mcPhaseRng);
         random->nextG(gaussVecs[threadNum]);
-        //  Path
+      }
+      //  Path
+      {
+        MCPROFILE_SCOPE(mcPhasePath);
         models[threadNum]->generatePath(gaussVecs[threadNum], paths[threadNum]);
-        //  Payoff
+      }
+      //  Payoff
+      {
+        MCPROFILE_SCOPE(mcPhasePayoffs);
         prd.payoffs(paths[threadNum], payoffs[threadNum]);
+      }
 
-        //  Propagate adjoints
-        Number result = aggFun(payoffs[threadNum]);
+      //  Propagate adjoints
+      Number result = aggFun(payoffs[threadNum]);
+      {
+        MCPROFILE_SCOPE(mcPhasePropagate);
         result.propagateToMark();
-        //  Store results for the path
-        results.aggregated[firstPath + i] = double(result);
-        convertCollection(payoffs[threadNum].begin(), payoffs[threadNum].end(),
-                          results.payoffs[firstPath + i].begin());
       }
+      //  Store results for the path
+      results.aggregated[firstPath + i] = double(result);
+      convertCollection(payoffs[threadNum].begin(), payoffs[threadNum].end(),
+                        results.payoffs[firstPath + i].begin());
+    }
+  };
+
+  //  Calibration: time a first batch of MINBATCH paths on the main thread
+  //      and size the remaining tasks accordingly
+  const size_t calibPaths = min<size_t>(nPath, MINBATCH);
+  const auto calibStart = chrono::high_resolution_clock::now();
+  simulateBatch(0, calibPaths);
+  const double calibMicros =
+      chrono::duration<double, micro>(chrono::high_resolution_clock::now() -
+                                      calibStart)
+          .count();
+  const size_t batchSize =
+      adaptiveBatchSize(nPath, nThread, calibPaths, calibMicros, batchSizeHint);
+
+  //  One completion object for the whole range of tasks
+  TaskGroup batches;
+
+  //  Start
+  //  Same as mcSimul() except we send tasks to the pool
+  //  instead of executing them
+
+  size_t firstPath = calibPaths;
+  size_t pathsLeft = nPath - calibPaths;
+  while (pathsLeft > 0) {
+    size_t pathsInTask = min<size_t>(pathsLeft, batchSize);
 
-      //  Remember tasks must return bool
-      return true;
-    }));
+    pool->spawnTask(batches, [&, firstPath, pathsInTask]() {
+      simulateBatch(firstPath, pathsInTask);
+    });
 
     pathsLeft -= pathsInTask;
     firstPath += pathsInTask;
   }
 
   //  Wait and help
-  for (auto &future : futures)
-    pool->activeWait(future);
+  pool->activeWait(batches);
 
   //  Mark = limit between pre-calculations and path-wise operations
   //  Operations above mark have been propagated and accumulated
-  //  We conduct one propagation mark to start
-  //  On the main thread's tape
+  //  We conduct one propagation mark to start, each tape exactly once
+  //  On the invoking thread's tape
+  Number::tape = mainTape;
   Number::propagateMarkToStart();
-  //  And on the worker thread's tapes
-  Tape *mainThreadPtr = Number::tape;
-  for (size_t i = 0; i < nThread; ++i) {
-    if (mdlInit[i + 1]) {
+  //  And on the other threads' tapes
+  for (size_t t = 0; t <= nThread; ++t) {
+    if (t != mainThreadNum && mdlInit[t]) {
       //  Set tape pointer
-      Number::tape = &tapes[i];
+      Number::tape = &tapes[t];
       //  On that tape, propagate
       Number::propagateMarkToStart();
     }
   }
-  //  Reset tape to main thread's
-  Number::tape = mainThreadPtr;
+  //  Reset tape to the invoking thread's
+  Number::tape = mainTape;
 
   //  Sum sensitivities over threads
   for (size_t j = 0; j < nParam; ++j) {
@@ -681,6 +2103,212 @@ inline AADSimulResults mcParallelSimulAAD(const Product<Number> &prd,
   return results;
 }
 
+//  Sharded simulation, the distribution layer
+//  ===========================================
+//  A run of nPathTotal paths is split into contiguous shards: shard
+//      k deterministically simulates global paths
+//      [k * size, (k+1) * size) on any host, because the RNG is
+//      repositioned through skipTo (Sobol, mrg32k3a and Philox all
+//      support it) - so results are reproducible and independent of
+//      where each shard runs.
+//  Shards reduce to compact, mergeable summaries (payoff statistics
+//      and risk vectors weighted by path count) with a binary wire
+//      format for transport between processes and hosts.
+
+//  RNG view on a shard: positions the generator on the shard's
+//      first global path at init, and offsets every skipTo,
+//      so the engines run the shard as if it were paths [0, n)
+class ShardRNG : public RNG {
+  unique_ptr<RNG> myBase;
+  unsigned myFirstPath;
+
+public:
+  ShardRNG(const RNG &base, const unsigned firstPath)
+      : myBase(base.clone()), myFirstPath(firstPath) {}
+
+  ShardRNG(const ShardRNG &rhs)
+      : myBase(rhs.myBase->clone()), myFirstPath(rhs.myFirstPath) {}
+
+  unique_ptr<RNG> clone() const override {
+    return make_unique<ShardRNG>(*this);
+  }
+
+  void init(const size_t simDim) override {
+    myBase->init(simDim);
+    myBase->skipTo(myFirstPath);
+  }
+
+  void nextU(vector<double> &uVec) override { myBase->nextU(uVec); }
+  void nextG(vector<double> &gaussVec) override { myBase->nextG(gaussVec); }
+  void nextGBlock(matrix<double> &gaussMat, const size_t nPoints) override {
+    myBase->nextGBlock(gaussMat, nPoints);
+  }
+
+  void skipTo(const unsigned b) override { myBase->skipTo(myFirstPath + b); }
+};
+
+//  One shard's summary: payoff statistics and risks,
+//      mergeable as path-count weighted combinations
+struct ShardResults {
+  size_t paths = 0;
+  //  Per payoff: mean and mean of squares (for standard errors)
+  vector<double> payoffMeans;
+  vector<double> payoffMeanSquares;
+  //  Aggregated payoff mean and the risks of the aggregate
+  double aggregated = 0.0;
+  vector<double> risks;
+
+  //  Weighted merge of another shard
+  void merge(const ShardResults &rhs) {
+    if (rhs.paths == 0)
+      return;
+    if (paths == 0) {
+      *this = rhs;
+      return;
+    }
+
+    const double w = double(paths) / (paths + rhs.paths);
+    const double v = 1.0 - w;
+    for (size_t i = 0; i < payoffMeans.size(); ++i) {
+      payoffMeans[i] = w * payoffMeans[i] + v * rhs.payoffMeans[i];
+      payoffMeanSquares[i] =
+          w * payoffMeanSquares[i] + v * rhs.payoffMeanSquares[i];
+    }
+    aggregated = w * aggregated + v * rhs.aggregated;
+    for (size_t i = 0; i < risks.size(); ++i) {
+      risks[i] = w * risks[i] + v * rhs.risks[i];
+    }
+    paths += rhs.paths;
+  }
+
+  //  Standard error of a payoff's mean
+  double stdErr(const size_t i) const {
+    const double var = payoffMeanSquares[i] - payoffMeans[i] * payoffMeans[i];
+    return sqrt(max(var, 0.0) / paths);
+  }
+
+  //  Compact wire format
+  string serialize() const {
+    string buf;
+    auto put = [&buf](const double x) {
+      buf.append(reinterpret_cast<const char *>(&x), sizeof(double));
+    };
+    auto putSize = [&buf](const size_t x) {
+      buf.append(reinterpret_cast<const char *>(&x), sizeof(size_t));
+    };
+    putSize(paths);
+    putSize(payoffMeans.size());
+    putSize(risks.size());
+    for (const double x : payoffMeans)
+      put(x);
+    for (const double x : payoffMeanSquares)
+      put(x);
+    put(aggregated);
+    for (const double x : risks)
+      put(x);
+    return buf;
+  }
+
+  static ShardResults deserialize(const string &buf) {
+    ShardResults results;
+    size_t pos = 0;
+    auto need = [&](const size_t bytes) {
+      if (pos + bytes > buf.size())
+        throw runtime_error("ShardResults : truncated wire data");
+    };
+    auto getSize = [&]() {
+      need(sizeof(size_t));
+      size_t x;
+      memcpy(&x, buf.data() + pos, sizeof(size_t));
+      pos += sizeof(size_t);
+      return x;
+    };
+    auto get = [&]() {
+      need(sizeof(double));
+      double x;
+      memcpy(&x, buf.data() + pos, sizeof(double));
+      pos += sizeof(double);
+      return x;
+    };
+    results.paths = getSize();
+    const size_t nPay = getSize(), nParam = getSize();
+    results.payoffMeans.resize(nPay);
+    results.payoffMeanSquares.resize(nPay);
+    results.risks.resize(nParam);
+    for (auto &x : results.payoffMeans)
+      x = get();
+    for (auto &x : results.payoffMeanSquares)
+      x = get();
+    results.aggregated = get();
+    for (auto &x : results.risks)
+      x = get();
+    return results;
+  }
+};
+
+//  The path range of a shard
+inline pair<size_t, size_t> shardRange(const size_t nPathTotal,
+                                       const size_t shard,
+                                       const size_t numShards) {
+  const size_t size = (nPathTotal + numShards - 1) / numShards;
+  const size_t first = min(shard * size, nPathTotal);
+  const size_t last = min(first + size, nPathTotal);
+  return make_pair(first, last);
+}
+
+//  Run one shard of an AAD risk job and reduce it to its summary
+//  Shard k on any host produces the exact same summary
+template <class F = decltype(defaultAggregator)>
+inline ShardResults mcSimulAADShard(const Product<Number> &prd,
+                                    const Model<Number> &mdl, const RNG &rng,
+                                    const size_t nPathTotal, const size_t shard,
+                                    const size_t numShards,
+                                    //  run the shard over the local pool?
+                                    const bool parallel = false,
+                                    const F &aggFun = defaultAggregator) {
+  if (shard >= numShards)
+    throw runtime_error("mcSimulAADShard() : shard out of range");
+
+  const auto range = shardRange(nPathTotal, shard, numShards);
+  const size_t nPath = range.second - range.first;
+
+  ShardResults results;
+  const size_t nPay = prd.payoffLabels().size();
+  results.payoffMeans.assign(nPay, 0.0);
+  results.payoffMeanSquares.assign(nPay, 0.0);
+  results.risks.assign(mdl.numParams(), 0.0);
+  if (nPath == 0)
+    return results;
+
+  //  The shard's deterministic slice of the sequence
+  ShardRNG shardRng(rng, unsigned(range.first));
+
+  const auto full = parallel
+                        ? mcParallelSimulAAD(prd, mdl, shardRng, nPath, aggFun)
+                        : mcSimulAAD(prd, mdl, shardRng, nPath, aggFun);
+
+  //  Reduce to the summary
+  results.paths = nPath;
+  for (size_t i = 0; i < nPath; ++i) {
+    for (size_t j = 0; j < nPay; ++j) {
+      const double x = full.payoffs[i][j];
+      results.payoffMeans[j] += x;
+      results.payoffMeanSquares[j] += x * x;
+    }
+    results.aggregated += full.aggregated[i];
+  }
+  for (size_t j = 0; j < nPay; ++j) {
+    results.payoffMeans[j] /= nPath;
+    results.payoffMeanSquares[j] /= nPath;
+  }
+  results.aggregated /= nPath;
+
+  //  Engine risks are averaged over the shard's paths already
+  results.risks = full.risks;
+
+  return results;
+}
+
 //  Multi-dimensional AAD, chapter 14
 //	Rewrite code for the risk reports of multiple payoffs for clarity
 
@@ -777,7 +2405,9 @@ inline AADMultiSimulResults mcSimulAADMulti(const Product<Number> &prd,
 inline AADMultiSimulResults mcParallelSimulAADMulti(const Product<Number> &prd,
                                                     const Model<Number> &mdl,
                                                     const RNG &rng,
-                                                    const size_t nPath) {
+                                                    const size_t nPath,
+                                                    //  0 = adaptive batch size
+                                                    const size_t batchSizeHint = 0) {
   if (!checkCompatiblity(prd, mdl))
     throw runtime_error("Model and product are not compatible");
 
@@ -790,92 +2420,127 @@ inline AADMultiSimulResults mcParallelSimulAADMulti(const Product<Number> &prd,
   ThreadPool *pool = ThreadPool::getInstance();
   const size_t nThread = pool->numThreads();
 
+  //  The "main" role belongs to the invoking thread,
+  //      see mcParallelSimulAAD
+  const size_t mainThreadNum = pool->threadNum();
+  Tape *const mainTape = Number::tape;
+
+  //  Invoking thread workspace allocated here,
+  //      the others first-touch their own
   vector<unique_ptr<Model<Number>>> models(nThread + 1);
   for (auto &model : models) {
     model = mdl.clone();
-    model->allocate(prd.timeline(), prd.defline());
   }
+  models[mainThreadNum]->allocate(prd.timeline(), prd.defline());
 
   vector<Scenario<Number>> paths(nThread + 1);
-  for (auto &path : paths) {
-    allocatePath(prd.defline(), path);
-  }
+  allocatePath(prd.defline(), paths[mainThreadNum]);
 
-  vector<vector<Number>> payoffs(nThread + 1, vector<Number>(nPay));
+  vector<vector<Number>> payoffs(nThread + 1);
+  payoffs[mainThreadNum].resize(nPay);
 
-  vector<Tape> tapes(nThread);
+  //  Tapes for the other threads, by thread number
+  vector<Tape> tapes(nThread + 1);
 
   vector<int> mdlInit(nThread + 1, false);
 
-  initModel4ParallelAAD(prd, *models[0], paths[0]);
+  initModel4ParallelAAD(prd, *models[mainThreadNum], paths[mainThreadNum]);
 
-  mdlInit[0] = true;
+  mdlInit[mainThreadNum] = true;
 
   vector<unique_ptr<RNG>> rngs(nThread + 1);
   for (auto &random : rngs) {
     random = rng.clone();
-    random->init(models[0]->simDim());
+    random->init(models[mainThreadNum]->simDim());
   }
 
-  vector<vector<double>> gaussVecs(nThread + 1,
-                                   vector<double>(models[0]->simDim()));
+  vector<vector<double>> gaussVecs(nThread + 1);
+  gaussVecs[mainThreadNum].resize(models[mainThreadNum]->simDim());
+
+  //  Dry run on the invoking thread, see mcParallelSimulAAD
+  const Tape::Footprint pathFootprint = reserveTapeFromDryRun(
+      prd, *models[mainThreadNum], *rngs[mainThreadNum], paths[mainThreadNum],
+      payoffs[mainThreadNum]);
 
   AADMultiSimulResults results(nPath, nPay, nParam);
 
-  vector<TaskHandle> futures;
-  futures.reserve(nPath / BATCHSIZE + 1);
+  //  The work for one batch of paths
+  auto simulateBatch = [&](const size_t firstPath, const size_t pathsInTask) {
+    const size_t threadNum = pool->threadNum();
 
-  size_t firstPath = 0;
-  size_t pathsLeft = nPath;
-  while (pathsLeft > 0) {
-    size_t pathsInTask = min<size_t>(pathsLeft, BATCHSIZE);
+    Number::tape = threadNum == mainThreadNum ? mainTape : &tapes[threadNum];
 
-    futures.push_back(pool->spawnTask([&, firstPath, pathsInTask]() {
-      const size_t threadNum = pool->threadNum();
+    if (!mdlInit[threadNum]) {
+      //  First touch, see mcParallelSimulAAD
+      Number::tape->clear();
+      models[threadNum]->allocate(prd.timeline(), prd.defline());
+      allocatePath(prd.defline(), paths[threadNum]);
+      payoffs[threadNum].resize(nPay);
+      gaussVecs[threadNum].resize(models[threadNum]->simDim());
 
-      if (threadNum > 0)
-        Number::tape = &tapes[threadNum - 1];
+      initModel4ParallelAAD(prd, *models[threadNum], paths[threadNum]);
+      Number::tape->reserve(pathFootprint);
+      mdlInit[threadNum] = true;
+    }
 
-      if (!mdlInit[threadNum]) {
-        initModel4ParallelAAD(prd, *models[threadNum], paths[threadNum]);
-        mdlInit[threadNum] = true;
-      }
+    auto &random = rngs[threadNum];
+    random->skipTo(firstPath);
 
-      auto &random = rngs[threadNum];
-      random->skipTo(firstPath);
+    for (size_t i = 0; i < pathsInTask; i++) {
 
-      for (size_t i = 0; i < pathsInTask; i++) {
+      Number::tape->rewindToMark();
+      random->nextG(gaussVecs[threadNum]);
+      models[threadNum]->generatePath(gaussVecs[threadNum], paths[threadNum]);
+      prd.payoffs(paths[threadNum], payoffs[threadNum]);
 
-        Number::tape->rewindToMark();
-        random->nextG(gaussVecs[threadNum]);
-        models[threadNum]->generatePath(gaussVecs[threadNum], paths[threadNum]);
-        prd.payoffs(paths[threadNum], payoffs[threadNum]);
+      const size_t n = payoffs[threadNum].size();
+      for (size_t j = 0; j < n; ++j) {
+        payoffs[threadNum][j].adjoint(j) = 1.0;
+      }
+      Number::propagateAdjointsMulti(prev(Number::tape->end()),
+                                     Number::tape->markIt());
 
-        const size_t n = payoffs[threadNum].size();
-        for (size_t j = 0; j < n; ++j) {
-          payoffs[threadNum][j].adjoint(j) = 1.0;
-        }
-        Number::propagateAdjointsMulti(prev(Number::tape->end()),
-                                       Number::tape->markIt());
+      convertCollection(payoffs[threadNum].begin(), payoffs[threadNum].end(),
+                        results.payoffs[firstPath + i].begin());
+    }
+  };
 
-        convertCollection(payoffs[threadNum].begin(), payoffs[threadNum].end(),
-                          results.payoffs[firstPath + i].begin());
-      }
+  //  Calibration: time a first batch of MINBATCH paths on the main thread
+  //      and size the remaining tasks accordingly
+  const size_t calibPaths = min<size_t>(nPath, MINBATCH);
+  const auto calibStart = chrono::high_resolution_clock::now();
+  simulateBatch(0, calibPaths);
+  const double calibMicros =
+      chrono::duration<double, micro>(chrono::high_resolution_clock::now() -
+                                      calibStart)
+          .count();
+  const size_t batchSize =
+      adaptiveBatchSize(nPath, nThread, calibPaths, calibMicros, batchSizeHint);
+
+  TaskGroup batches;
+
+  size_t firstPath = calibPaths;
+  size_t pathsLeft = nPath - calibPaths;
+  while (pathsLeft > 0) {
+    size_t pathsInTask = min<size_t>(pathsLeft, batchSize);
 
-      return true;
-    }));
+    pool->spawnTask(batches, [&, firstPath, pathsInTask]() {
+      simulateBatch(firstPath, pathsInTask);
+    });
 
     pathsLeft -= pathsInTask;
     firstPath += pathsInTask;
   }
 
-  for (auto &future : futures)
-    pool->activeWait(future);
+  pool->activeWait(batches);
 
-  Number::propagateAdjointsMulti(Number::tape->markIt(), Number::tape->begin());
-  for (size_t i = 0; i < nThread; ++i) {
-    if (mdlInit[i + 1]) {
-      Number::propagateAdjointsMulti(tapes[i].markIt(), tapes[i].begin());
+  //  Final propagation, each tape exactly once,
+  //      starting with the invoking thread's
+  Number::tape = mainTape;
+  Number::propagateAdjointsMulti(mainTape->markIt(), mainTape->begin());
+  for (size_t t = 0; t <= nThread; ++t) {
+    if (t != mainThreadNum && mdlInit[t]) {
+      Number::propagateAdjointsMulti(tapes[t].markIt(), tapes[t].begin());
     }
   }
 
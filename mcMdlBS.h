@@ -227,6 +227,9 @@ public:
   //  MC Dimension
   size_t simDim() const override { return myTimeline.size() - 1; }
 
+  //  Simulation timeline, for the multilevel engine
+  const vector<Time> *simTimeline() const override { return &myTimeline; }
+
 private:
   //  Helper function, fills a Sample given the spot
   inline void fillScen(const size_t idx,     //  index on product timeline
@@ -278,4 +281,33 @@ public:
       ++idx;
     }
   }
+
+  //  Segment-wise generation for checkpointed AAD, see mcBase.h
+  //  One simulation step per event date after today,
+  //      the state is the spot at the segment boundary
+  bool supportsSegments() const override { return true; }
+
+  void initState(vector<T> &state) const override {
+    state.resize(1);
+    state[0] = mySpot;
+  }
+
+  void generateSegment(const vector<double> &gaussVec, Scenario<T> &path,
+                       vector<T> &state, const size_t firstEvent,
+                       const size_t lastEvent) const override {
+    size_t idx = firstEvent;
+    //  Today, no simulation step
+    if (idx == 0 && myTodayOnTimeline) {
+      fillScen(idx, state[0], path[idx], (*myDefline)[idx]);
+      ++idx;
+    }
+
+    //  Event idx is produced by simulation step idx - offset
+    const size_t offset = myTodayOnTimeline ? 1 : 0;
+    for (; idx < lastEvent; ++idx) {
+      const size_t i = idx - offset;
+      state[0] = state[0] * exp(myDrifts[i] + myStds[i] * gaussVec[i]);
+      fillScen(idx, state[0], path[idx], (*myDefline)[idx]);
+    }
+  }
 };
\ No newline at end of file
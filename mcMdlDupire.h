@@ -36,6 +36,12 @@ template <class T> class Dupire : public Model<T> {
   const vector<double> mySpots;
   //  We keep log spots to interpolate in log space
   vector<double> myLogSpots;
+  //  Precompiled uniform bracket table over the log spot grid:
+  //      the hot path lookup becomes an index computation
+  //      plus at most one correction step, instead of a binary search
+  vector<unsigned> myIdxTab;
+  double myTabLo;
+  double myTabInvStep;
   const vector<Time> myTimes;
   //  Local vols
   //  Spot major: sigma(spot i, time j) = myVols[i][j]
@@ -51,6 +57,22 @@ template <class T> class Dupire : public Model<T> {
   //  true (1) if the time step is an event date
   //  false (0) if it is an additional simulation step
   vector<bool> myCommonSteps;
+  //  Timeline index of each product event date,
+  //      for segment-wise generation
+  vector<size_t> myEventSteps;
+
+  //  Pathwise adjoint workspace and precomputations
+  //      (double instantiation, see generatePathStoring below)
+  //  Time interpolation chain of each step's pre-interpolated row:
+  //      myInterpVols[i][j] = sqrtdt_i * ((1-u_i) * myVols[j][k_i]
+  //                                       + u_i * myVols[j][k_i+1])
+  vector<size_t> myTimeKs;
+  vector<double> myTimeUs;
+  vector<double> mySqrtDts;
+  //  Stored path: log spots at every step boundary, the interpolated
+  //      vols, the spot brackets and weights, and the Gaussians
+  vector<double> myPathLogSpots, myPathVols, myPathWeights, myPathGauss;
+  vector<size_t> myPathBrackets;
 
   //  The pruduct's defline byref
   const vector<SampleDef> *myDefline;
@@ -81,6 +103,29 @@ public:
     transform(mySpots.begin(), mySpots.end(), myLogSpots.begin(),
               [](const double s) { return log(s); });
 
+    //  Precompile the uniform bracket table:
+    //      step below the smallest knot spacing,
+    //      so a bucket contains at most one knot
+    myTabLo = 0.0;
+    myTabInvStep = 0.0;
+    if (myLogSpots.size() > 1 && myLogSpots.back() > myLogSpots.front()) {
+      const double lo = myLogSpots.front(), hi = myLogSpots.back();
+      double minDx = hi - lo;
+      for (size_t i = 1; i < myLogSpots.size(); ++i)
+        minDx = min(minDx, myLogSpots[i] - myLogSpots[i - 1]);
+      const size_t buckets =
+          min<size_t>(size_t((hi - lo) / minDx) + 1, 4096);
+      myTabLo = lo;
+      myTabInvStep = buckets / (hi - lo);
+      myIdxTab.resize(buckets + 1);
+      for (size_t u = 0; u <= buckets; ++u) {
+        const double x = lo + u / myTabInvStep;
+        myIdxTab[u] = unsigned(distance(
+            myLogSpots.begin(),
+            upper_bound(myLogSpots.begin(), myLogSpots.end(), x)));
+      }
+    }
+
     //  Set parameter labels once
     myParameterLabels[0] = "spot";
 
@@ -149,6 +194,13 @@ public:
                                      productTimeline.end(), t);
               });
 
+    //  Timeline index of each event date
+    myEventSteps.clear();
+    for (size_t i = 0; i < myTimeline.size(); ++i) {
+      if (myCommonSteps[i])
+        myEventSteps.push_back(i);
+    }
+
     //  Take a reference on the product's defline
     myDefline = &defline;
 
@@ -162,8 +214,30 @@ public:
     //  Compute the local volatilities
     //      pre-interpolated in time and multiplied by sqrt(dt)
     const size_t n = myTimeline.size() - 1;
+    myTimeKs.resize(n);
+    myTimeUs.resize(n);
+    mySqrtDts.resize(n);
+    const size_t nT = myTimes.size();
     for (size_t i = 0; i < n; ++i) {
       const double sqrtdt = sqrt(myTimeline[i + 1] - myTimeline[i]);
+      mySqrtDts[i] = sqrtdt;
+
+      //  Time bracket and weight, kept for the pathwise adjoints
+      const size_t n2 = distance(
+          myTimes.begin(),
+          upper_bound(myTimes.begin(), myTimes.end(), myTimeline[i]));
+      if (n2 == nT) {
+        myTimeKs[i] = nT - 1;
+        myTimeUs[i] = 0.0;
+      } else if (n2 == 0) {
+        myTimeKs[i] = 0;
+        myTimeUs[i] = 0.0;
+      } else {
+        myTimeKs[i] = n2 - 1;
+        myTimeUs[i] =
+            (myTimeline[i] - myTimes[n2 - 1]) / (myTimes[n2] - myTimes[n2 - 1]);
+      }
+
       const size_t m = myLogSpots.size();
       for (size_t j = 0; j < m; ++j) {
         myInterpVols[i][j] =
@@ -176,7 +250,48 @@ public:
   //  MC Dimension
   size_t simDim() const override { return myTimeline.size() - 1; }
 
+  //  Simulation timeline, for the multilevel engine
+  const vector<Time> *simTimeline() const override { return &myTimeline; }
+
 private:
+  //  Bracket of x on the log spot grid from the precompiled table,
+  //      same result as the binary search in interp()
+  size_t bracket(const double x) const {
+    const size_t m = myLogSpots.size();
+    if (x < myLogSpots.front())
+      return 0;
+    if (x >= myLogSpots.back())
+      return m;
+
+    size_t bucket = size_t((x - myTabLo) * myTabInvStep);
+    bucket = min(bucket, myIdxTab.size() - 1);
+    size_t n2 = myIdxTab[bucket];
+    //  At most one step each way in practice,
+    //      exactness does not depend on the table
+    while (n2 < m && myLogSpots[n2] <= x)
+      ++n2;
+    while (n2 > 0 && myLogSpots[n2 - 1] > x)
+      --n2;
+    return n2;
+  }
+
+  //  Interpolate a pre-interpolated vol row in log spot,
+  //      identical arithmetic to interp() with the table bracket
+  template <class X, class Y>
+  Y volFromRow(const X &logspot, const Y *row) const {
+    const size_t m = myLogSpots.size();
+    const size_t n2 = bracket(double(logspot));
+
+    if (n2 == m)
+      return row[m - 1];
+    if (n2 == 0)
+      return row[0];
+
+    const size_t n = n2 - 1;
+    const auto t = (logspot - myLogSpots[n]) / (myLogSpots[n + 1] - myLogSpots[n]);
+    return row[n] + (row[n + 1] - row[n]) * t;
+  }
+
   //  Helper function, fills a sample given the spot
   inline static void fillScen(const T &spot, Sample<T> &scen) {
     fill(scen.forwards.front().begin(), scen.forwards.front().end(), spot);
@@ -202,11 +317,9 @@ public:
 
     //  Iterate through timeline
     const size_t n = myTimeline.size() - 1;
-    const size_t m = myLogSpots.size();
     for (size_t i = 0; i < n; ++i) {
-      //  Interpolate volatility in spot
-      T vol = interp(myLogSpots.begin(), myLogSpots.end(), myInterpVols[i],
-                     myInterpVols[i] + m, logspot);
+      //  Interpolate volatility in spot, precompiled bracket
+      T vol = volFromRow(logspot, myInterpVols[i]);
       //  vol comes out * sqrt(dt)
 
       //  Apply Euler's scheme
@@ -219,6 +332,231 @@ public:
       }
     }
   }
+
+  //  Segment-wise generation for checkpointed AAD, see mcBase.h
+  //  The state is the log spot at the segment boundary
+  bool supportsSegments() const override { return true; }
+
+  void initState(vector<T> &state) const override {
+    state.resize(1);
+    state[0] = log(mySpot);
+  }
+
+  void generateSegment(const vector<double> &gaussVec, Scenario<T> &path,
+                       vector<T> &state, const size_t firstEvent,
+                       const size_t lastEvent) const override {
+    size_t idx = firstEvent;
+    //  Today, no simulation step
+    if (idx == 0 && myCommonSteps[0]) {
+      fillScen(exp(state[0]), path[idx]);
+      ++idx;
+    }
+    if (idx >= lastEvent)
+      return;
+
+    //  Simulation steps from the previous event boundary
+    //      to the last event of the segment
+    const size_t firstStep = idx == 0 ? 0 : myEventSteps[idx - 1];
+    const size_t lastStep = myEventSteps[lastEvent - 1];
+    for (size_t i = firstStep; i < lastStep; ++i) {
+      T vol = volFromRow(state[0], myInterpVols[i]);
+      state[0] += vol * (-0.5 * vol + gaussVec[i]);
+
+      if (myCommonSteps[i + 1]) {
+        fillScen(exp(state[0]), path[idx]);
+        ++idx;
+      }
+    }
+  }
+
+  //  Pathwise adjoints, see mcSimulAADHybrid in mcBase.h
+  //  The Euler log step L' = L + v(L)(g - v(L)/2) and the linear
+  //      interpolations have closed form adjoints: the forward pass
+  //      stores the log spots, vols, brackets and weights, and the
+  //      backward pass chains the samples' adjoints to the spot and
+  //      the local vol grid without any tape
+  bool supportsPathAdjoints() const override {
+    return is_same<T, double>::value;
+  }
+
+  void generatePathStoring(const vector<double> &gaussVec,
+                           Scenario<double> &path) override {
+    if constexpr (is_same<T, double>::value) {
+      const size_t n = myTimeline.size() - 1;
+      myPathLogSpots.resize(n + 1);
+      myPathVols.resize(n);
+      myPathWeights.resize(n);
+      myPathBrackets.resize(n);
+      myPathGauss.assign(gaussVec.begin(), gaussVec.begin() + n);
+
+      double logspot = log(mySpot);
+      myPathLogSpots[0] = logspot;
+      size_t idx = 0;
+      if (myCommonSteps[idx]) {
+        fillScen(exp(logspot), path[idx]);
+        ++idx;
+      }
+
+      const size_t m = myLogSpots.size();
+      for (size_t i = 0; i < n; ++i) {
+        //  Interpolate, storing the bracket and weight
+        const size_t n2 = bracket(logspot);
+        myPathBrackets[i] = n2;
+        const double *row = myInterpVols[i];
+        double vol;
+        if (n2 == m) {
+          vol = row[m - 1];
+          myPathWeights[i] = 0.0;
+        } else if (n2 == 0) {
+          vol = row[0];
+          myPathWeights[i] = 0.0;
+        } else {
+          const double t = (logspot - myLogSpots[n2 - 1]) /
+                           (myLogSpots[n2] - myLogSpots[n2 - 1]);
+          vol = row[n2 - 1] + (row[n2] - row[n2 - 1]) * t;
+          myPathWeights[i] = t;
+        }
+        myPathVols[i] = vol;
+
+        logspot += vol * (-0.5 * vol + gaussVec[i]);
+        myPathLogSpots[i + 1] = logspot;
+
+        if (myCommonSteps[i + 1]) {
+          fillScen(exp(logspot), path[idx]);
+          ++idx;
+        }
+      }
+    }
+  }
+
+  void propagatePathAdjoints(const Scenario<double> &pathAdjoints,
+                             vector<double> &paramAdjoints) override {
+    if constexpr (is_same<T, double>::value) {
+      const size_t n = myTimeline.size() - 1;
+      const size_t m = myLogSpots.size();
+      const size_t nT = myTimes.size();
+
+      //  Adjoint of myInterpVols[i][j] chains into the vol grid:
+      //      myVols[j][k] and myVols[j][k+1] with the time weights
+      //      (parameters layout: 0 = spot, then myVols row major)
+      auto addRowAdj = [&](const size_t i, const size_t j, const double w) {
+        const size_t k = myTimeKs[i];
+        const double u = myTimeUs[i], sqrtdt = mySqrtDts[i];
+        paramAdjoints[1 + j * nT + k] += w * sqrtdt * (1.0 - u);
+        if (u > 0.0)
+          paramAdjoints[1 + j * nT + k + 1] += w * sqrtdt * u;
+      };
+
+      //  Adjoints of the event samples, walked backwards
+      double dL = 0.0;
+      size_t idx = 0;
+      for (size_t i = 0; i <= n; ++i)
+        if (myCommonSteps[i])
+          ++idx;
+
+      for (size_t i = n; i-- > 0;) {
+        //  Sample filled at the end of this step?
+        if (myCommonSteps[i + 1]) {
+          --idx;
+          const Sample<double> &adj = pathAdjoints[idx];
+          double a = 0.0;
+          for (const double x : adj.forwards[0])
+            a += x;
+          //  All the forwards are S = exp(L)
+          dL += a * exp(myPathLogSpots[i + 1]);
+        }
+
+        //  Step backward: L' = L + v (g - v/2)
+        const double v = myPathVols[i], g = myPathGauss[i];
+        const double dfdv = g - v;
+        const double av = dL * dfdv; //  adjoint of the interpolated vol
+
+        //  Distribute to the pre-interpolated row and the grid
+        const size_t n2 = myPathBrackets[i];
+        double slope = 0.0;
+        if (n2 == m) {
+          addRowAdj(i, m - 1, av);
+        } else if (n2 == 0) {
+          addRowAdj(i, 0, av);
+        } else {
+          const double t = myPathWeights[i];
+          addRowAdj(i, n2 - 1, av * (1.0 - t));
+          addRowAdj(i, n2, av * t);
+          slope = (myInterpVols[i][n2] - myInterpVols[i][n2 - 1]) /
+                  (myLogSpots[n2] - myLogSpots[n2 - 1]);
+        }
+
+        //  And through the log spot
+        dL *= 1.0 + dfdv * slope;
+      }
+
+      //  Today's sample, no step
+      if (myCommonSteps[0]) {
+        const Sample<double> &adj = pathAdjoints[0];
+        double a = 0.0;
+        for (const double x : adj.forwards[0])
+          a += x;
+        dL += a * exp(myPathLogSpots[0]);
+      }
+
+      //  Finally the spot: L0 = log(spot)
+      paramAdjoints[0] += dL / double(mySpot);
+    }
+  }
+
+  //  Generate a batch of paths, one row of Gaussians per path
+  //  For the double instantiation, all the paths in the batch
+  //      advance through the time loop simultaneously:
+  //      the local vol lookups are gathered in one pass per step
+  //      and the Euler updates run in a tight, vectorizable lane loop
+  void generatePaths(const matrix<double> &gaussVecs,
+                     Scenario<T> *const *paths,
+                     const size_t nPaths) const override {
+    if constexpr (is_same<T, double>::value) {
+      //  Lane state, one logspot and one vol per path in the batch
+      static thread_local vector<double> logspots, vols;
+      logspots.resize(nPaths);
+      vols.resize(nPaths);
+
+      //  The starting spot
+      //  We know that today is on the timeline
+      fill(logspots.begin(), logspots.end(), log(mySpot));
+      //  Next index to fill on the product timeline
+      size_t idx = 0;
+      //  Is today on the product timeline?
+      if (myCommonSteps[idx]) {
+        for (size_t k = 0; k < nPaths; ++k)
+          fillScen(exp(logspots[k]), (*paths[k])[idx]);
+        ++idx;
+      }
+
+      //  Iterate through timeline
+      const size_t n = myTimeline.size() - 1;
+      for (size_t i = 0; i < n; ++i) {
+        //  Gather the volatilities, one lookup per lane
+        const double *iv = myInterpVols[i];
+        for (size_t k = 0; k < nPaths; ++k) {
+          vols[k] = volFromRow(logspots[k], iv);
+        }
+        //  vols come out * sqrt(dt)
+
+        //  Apply Euler's scheme across the lanes
+        for (size_t k = 0; k < nPaths; ++k) {
+          logspots[k] += vols[k] * (-0.5 * vols[k] + gaussVecs[k][i]);
+        }
+
+        //  Store on the paths?
+        if (myCommonSteps[i + 1]) {
+          for (size_t k = 0; k < nPaths; ++k)
+            fillScen(exp(logspots[k]), (*paths[k])[idx]);
+          ++idx;
+        }
+      }
+    } else {
+      //  Instrumented instantiations keep the one-path-at-a-time code
+      Model<T>::generatePaths(gaussVecs, paths, nPaths);
+    }
+  }
 };
 
 //  Calibration
@@ -307,10 +645,25 @@ inline auto dupireCalib(
   matrix<T> lVolsT(results.times.size(), results.spots.size());
 
   //  Maturity by maturity
+  //  The maturities are independent: for the plain double calibration
+  //      they run in parallel over the thread pool
+  //      (the instrumented calibration records on tape and stays serial)
   const size_t n = results.times.size();
-  for (size_t j = 0; j < n; ++j) {
-    dupireCalibMaturity(ivs, results.times[j], results.spots.begin(),
-                        results.spots.end(), lVolsT[j], riskView);
+  if constexpr (is_same<T, double>::value) {
+    ThreadPool *pool = ThreadPool::getInstance();
+    TaskGroup maturities;
+    for (size_t j = 0; j < n; ++j) {
+      pool->spawnTask(maturities, [&, j]() {
+        dupireCalibMaturity(ivs, results.times[j], results.spots.begin(),
+                            results.spots.end(), lVolsT[j], riskView);
+      });
+    }
+    pool->activeWait(maturities);
+  } else {
+    for (size_t j = 0; j < n; ++j) {
+      dupireCalibMaturity(ivs, results.times[j], results.spots.begin(),
+                          results.spots.end(), lVolsT[j], riskView);
+    }
   }
 
   //  transpose is defined in matrix.h
@@ -318,3 +671,41 @@ inline auto dupireCalib(
 
   return results;
 }
+
+//  Incremental recalibration, chapter 13 risk workflow
+//  After a bump of one knot of the risk view, only the maturities
+//      whose spreads the knot influences change: the bump moves the
+//      IVS between the neighboring view knots (extended to the grid
+//      edge at the boundary, extrapolation being flat), so only those
+//      columns of the surface are recomputed, in place
+//  Granularity is the maturity: dupireCalibMaturity stays the unit
+//      of work, so the recomputed columns match a full recalibration
+//      to the bit
+template <class T = double>
+inline void dupireCalibIncremental(
+    //  The IVS we calibrate to
+    const IVS &ivs,
+    //  The calibrated surface, spot major, updated in place
+    const vector<double> &spots, const vector<Time> &times, matrix<T> &lVols,
+    //  The (already bumped) risk view and the bumped maturity knot
+    const RiskView<T> &riskView, const size_t bumpedMat) {
+  //  Influenced time range, widened by localVol's finite difference step
+  const vector<Time> &knots = riskView.mats();
+  const double fd = 2.0e-04;
+  const double lo = bumpedMat == 0 ? -1.0e+99 : knots[bumpedMat - 1] - fd;
+  const double hi =
+      bumpedMat == knots.size() - 1 ? 1.0e+99 : knots[bumpedMat + 1] + fd;
+
+  const size_t nSpots = spots.size();
+  vector<T> column(nSpots);
+  const size_t n = times.size();
+  for (size_t j = 0; j < n; ++j) {
+    if (times[j] <= lo || times[j] >= hi)
+      continue;
+
+    dupireCalibMaturity(ivs, times[j], spots.begin(), spots.end(),
+                        column.begin(), riskView);
+    for (size_t i = 0; i < nSpots; ++i)
+      lVols[i][j] = column[i];
+  }
+}
@@ -70,6 +70,9 @@ template <class T> class MultiDisplaced : public Model<T> {
   vector<T> myAlphas;
   vector<T> myBetas;
   vector<Dynamics> myDynamics;
+  //	Assets grouped by dynamics, so the double stepping kernel
+  //	runs branch-free group loops instead of a switch per asset
+  vector<size_t> myLognormals, myNormals, mySurnormals, mySubnormals;
 
   //	Finally, correl
   //	Lower diagonal matrix
@@ -81,6 +84,12 @@ template <class T> class MultiDisplaced : public Model<T> {
   //	Cholesky coefs, also lower diagonal
   matrix<T> myChol;
 
+  //	Factorization cache for the plain double instantiation:
+  //	correlation inputs (lower triangle + lambda) of the last init,
+  //	so repeated inits with unchanged correlation (spot or vol bumps)
+  //	skip the O(n^3) refactorization and reuse the factor
+  vector<double> myCorrelCache;
+
   //  Similuation timeline = today + div dates + event dates
   vector<Time> myTimeline;
   //  Is today on product timeline?
@@ -402,23 +411,46 @@ public:
       }
     }
 
-    //	Rebuild correl matrix for lower triangular
-    for (size_t i = 0; i < myCorrel.rows(); ++i) {
-      myCorrel[i][i] = 1.0;
-      for (size_t j = i; j < myCorrel.cols(); ++j) {
-        myCorrel[i][j] = myCorrel[j][i];
+    //	Factorize the correlation, unless the plain double instantiation
+    //	can prove the inputs unchanged since the last init and
+    //	reuse the cached factor (the instrumented instantiation
+    //	always refactorizes: the factor must live on tape)
+    bool factorize = true;
+    if constexpr (is_same<T, double>::value) {
+      vector<double> key;
+      key.reserve(myNumAssets * (myNumAssets - 1) / 2 + 1);
+      for (size_t i = 1; i < myNumAssets; ++i)
+        for (size_t j = 0; j < i; ++j)
+          key.push_back(myCorrel[i][j]);
+      key.push_back(myLambda);
+
+      if (key == myCorrelCache && !myChol.empty()) {
+        factorize = false;
+      } else {
+        myCorrelCache = move(key);
       }
     }
 
-    //	Apply lambda shift to correl
-    transform(
-        myCorrel.begin(), myCorrel.end(), myUsedCorrel.begin(),
-        [&](const T &rawCorr) { return myLambda * (1.0 - rawCorr) + rawCorr; });
+    if (factorize) {
+      //	Rebuild correl matrix for lower triangular
+      for (size_t i = 0; i < myCorrel.rows(); ++i) {
+        myCorrel[i][i] = 1.0;
+        for (size_t j = i; j < myCorrel.cols(); ++j) {
+          myCorrel[i][j] = myCorrel[j][i];
+        }
+      }
 
-    //	Apply Choleski decomposition (see Numerical Recipes) to correlation
-    //matrix 	If Wi are independent standard Gaussians, then: 	Bi = sum(CHOLij *
-    //Wj) 	are correlated standard Gaussians with the correct correl
-    choldc(myUsedCorrel, myChol);
+      //	Apply lambda shift to correl
+      transform(myCorrel.begin(), myCorrel.end(), myUsedCorrel.begin(),
+                [&](const T &rawCorr) {
+                  return myLambda * (1.0 - rawCorr) + rawCorr;
+                });
+
+      //	Apply Choleski decomposition (see Numerical Recipes) to correlation
+      //matrix 	If Wi are independent standard Gaussians, then: 	Bi = sum(CHOLij *
+      //Wj) 	are correlated standard Gaussians with the correct correl
+      choldc(myUsedCorrel, myChol);
+    }
 
     //  Pre-compute the standard devs and drifts over simulation timeline
     const size_t nt = myTimeline.size() - 1;
@@ -444,6 +476,29 @@ public:
       }
     }
 
+    //	Group the assets by dynamics for the stepping kernel
+    myLognormals.clear();
+    myNormals.clear();
+    mySurnormals.clear();
+    mySubnormals.clear();
+    for (size_t a = 0; a < myNumAssets; ++a) {
+      switch (myDynamics[a]) {
+      case Lognormal:
+        myLognormals.push_back(a);
+        break;
+      case Normal:
+        myNormals.push_back(a);
+        break;
+      case Surnormal:
+        mySurnormals.push_back(a);
+        break;
+      case Subnormal:
+      default:
+        mySubnormals.push_back(a);
+        break;
+      }
+    }
+
     //  Pre-compute the numeraires, discount and forward factors
     //      on event dates
     const size_t m = productTimeline.size();
@@ -539,6 +594,51 @@ public:
 
     //  Iterate through timeline, apply sampling scheme
     const size_t n = myTimeline.size() - 1;
+
+    //  Plain double instantiation: the precomputed per-step rows
+    //      (stds, drifts, forward factors) are contiguous per time
+    //      step, the correlated Brownian stays in register, and the
+    //      assets advance in dynamics groups so the update loops
+    //      carry no switch; arithmetic and order match the generic path
+    if constexpr (is_same<T, double>::value) {
+      for (size_t i = 0; i < n; ++i) {
+        const double *w = gaussVec.data() + i * myNumAssets;
+        const double *stds = myStds[i], *drifts = myDrifts[i],
+                     *ffs = myDynFwdFacts[i];
+
+        auto brownian = [&](const size_t a) {
+          const double *row = myChol[a];
+          double s = 0.0;
+          for (size_t k = 0; k <= a; ++k) {
+            s += row[k] * w[k];
+          }
+          return s;
+        };
+
+        for (const size_t a : myLognormals) {
+          spots[a] = spots[a] * ffs[a] * exp(drifts[a] + stds[a] * brownian(a));
+        }
+        for (const size_t a : myNormals) {
+          spots[a] = spots[a] * ffs[a] + stds[a] * brownian(a);
+        }
+        for (const size_t a : mySurnormals) {
+          spots[a] = (spots[a] * ffs[a] + myAlphas[a]) *
+                         exp(drifts[a] + stds[a] * brownian(a)) -
+                     myAlphas[a];
+        }
+        for (const size_t a : mySubnormals) {
+          spots[a] = (spots[a] * ffs[a] - myAlphas[a]) *
+                         exp(drifts[a] + stds[a] * brownian(a)) +
+                     myAlphas[a];
+        }
+
+        fillScen(idx, spots, path[idx], (*myDefline)[idx]);
+        ++idx;
+      }
+
+      return;
+    }
+
     for (size_t i = 0; i < n; ++i) {
       //  Brownian increments for this time step
       const double *w = gaussVec.data() + i * myNumAssets;
@@ -579,4 +679,63 @@ public:
       ++idx;
     }
   }
+
+  //  Segment-wise generation, see mcBase.h
+  //  One simulation step per event date after today,
+  //      the state is the vector of spots at the segment boundary
+  bool supportsSegments() const override { return true; }
+
+  void initState(vector<T> &state) const override {
+    state.resize(myNumAssets);
+    copy(mySpots.begin(), mySpots.end(), state.begin());
+  }
+
+  void generateSegment(const vector<double> &gaussVec, Scenario<T> &path,
+                       vector<T> &state, const size_t firstEvent,
+                       const size_t lastEvent) const override {
+    size_t idx = firstEvent;
+    //  Today, no simulation step
+    if (idx == 0 && myTodayOnTimeline) {
+      fillScen(idx, state, path[idx], (*myDefline)[idx]);
+      ++idx;
+    }
+
+    //  Event idx is produced by simulation step idx - offset
+    const size_t offset = myTodayOnTimeline ? 1 : 0;
+    for (; idx < lastEvent; ++idx) {
+      const size_t i = idx - offset;
+      const double *w = gaussVec.data() + i * myNumAssets;
+
+      for (size_t a = 0; a < myNumAssets; ++a) {
+        T cw(0.0);
+        for (size_t k = 0; k <= a; ++k) {
+          cw += myChol[a][k] * w[k];
+        }
+
+        T fwd = state[a] * myDynFwdFacts[i][a];
+
+        switch (myDynamics[a]) {
+        case Lognormal:
+          state[a] = fwd * exp(myDrifts[i][a] + myStds[i][a] * cw);
+          break;
+        case Normal:
+          state[a] = fwd + myStds[i][a] * cw;
+          break;
+        case Surnormal:
+          state[a] =
+              (fwd + myAlphas[a]) * exp(myDrifts[i][a] + myStds[i][a] * cw) -
+              myAlphas[a];
+          break;
+        case Subnormal:
+        default:
+          state[a] =
+              (fwd - myAlphas[a]) * exp(myDrifts[i][a] + myStds[i][a] * cw) +
+              myAlphas[a];
+          break;
+        }
+      }
+
+      fillScen(idx, state, path[idx], (*myDefline)[idx]);
+    }
+  }
 };
\ No newline at end of file
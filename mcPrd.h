@@ -97,6 +97,25 @@ public:
     payoffs.front() =
         max(spot - myStrike, 0.0) * sample.discounts.front() / sample.numeraire;
   }
+
+  //  Static payoff kernel, see mcBase.h: the whole payoff is one
+  //      expression, evaluated record-free with its adjoints
+  //      accumulated straight into the samples' nodes
+  bool supportsStaticPayoff() const override {
+    return is_same<T, Number>::value;
+  }
+
+  double staticPayoff(const Scenario<T> &path) const override {
+    if constexpr (is_same<T, Number>::value) {
+      const auto &sample = path.front();
+      const auto expr = max(sample.forwards.front().front() - myStrike, 0.0) *
+                        sample.discounts.front() / sample.numeraire;
+      expr.accumulateAdjoints(1.0);
+      return expr.value();
+    } else {
+      return 0.0;
+    }
+  }
 };
 
 template <class T> class UOC : public Product<T> {
@@ -296,6 +315,27 @@ public:
       vector<T> &payoffs) const override {
     const size_t numT = myMaturities.size();
 
+    //  Plain double instantiation: the whole strike vector of each
+    //      maturity in one tight SIMD-friendly loop - broadcast
+    //      spot, vector max against the contiguous strikes, one
+    //      reciprocal of the numeraire instead of one division per
+    //      strike (a last-ulp change vs the generic path)
+    if constexpr (is_same<T, double>::value) {
+      size_t offset = 0;
+      for (size_t i = 0; i < numT; ++i) {
+        const double spot = path[i].forwards.front().front();
+        const double invNum = 1.0 / path[i].numeraire;
+        const double *ks = myStrikes[i].data();
+        double *out = payoffs.data() + offset;
+        const size_t n = myStrikes[i].size();
+        for (size_t j = 0; j < n; ++j) {
+          out[j] = max(spot - ks[j], 0.0) * invNum;
+        }
+        offset += n;
+      }
+      return;
+    }
+
     auto payoffIt = payoffs.begin();
     for (size_t i = 0; i < numT; ++i) {
       transform(myStrikes[i].begin(), myStrikes[i].end(), payoffIt,
@@ -227,10 +227,22 @@ public:
       vector<T> &payoffs) const override {
     T basket = inner_product(myWeights.begin(), myWeights.end(),
                              path[0].forwards.begin(), T(0.0), plus<T>(),
-                             [](const double weight, const vector<T> &fwds) {
+                             [](const double weight, const auto &fwds) {
                                return weight * fwds[0];
                              });
 
+    //  Plain double instantiation: whole strike vector in one
+    //      SIMD-friendly loop, single numeraire reciprocal
+    if constexpr (is_same<T, double>::value) {
+      const double invNum = 1.0 / path[0].numeraire;
+      const double *ks = myStrikes.data();
+      const size_t n = myStrikes.size();
+      for (size_t j = 0; j < n; ++j) {
+        payoffs[j] = max(basket - ks[j], 0.0) * invNum;
+      }
+      return;
+    }
+
     transform(myStrikes.begin(), myStrikes.end(), payoffs.begin(),
               [&basket, num = path[0].numeraire](const double k) {
                 return max(basket - k, 0.0) / num;
@@ -319,6 +331,25 @@ public:
   //  Labels
   const vector<string> &payoffLabels() const override { return myLabels; }
 
+  //  Early exit, see mcBase.h: once the worst performance reaches
+  //      KO + smooth the notional is fully redeemed, so the later
+  //      events carry exactly zero weight in payoffs()
+  bool supportsEarlyExit() const override { return true; }
+
+  bool terminated(const Scenario<T> &path, const size_t event) const override {
+    //  The last period settles the payoff anyway
+    if (event + 1 >= size_t(myNumPeriods))
+      return false;
+
+    const auto &state = path[event];
+    double worst = double(state.forwards[0][0]) / myRefs[0];
+    for (size_t a = 1; a < myNumAssets; ++a) {
+      worst = min(worst, double(state.forwards[a][0]) / myRefs[a]);
+    }
+
+    return worst >= myKO + mySmooth;
+  }
+
   //  Payoff
   void payoffs(
       //  path, one entry per time step
@@ -336,7 +367,7 @@ public:
     for (int step = 0; step < myNumPeriods - 1; ++step) {
       auto &state = path[step];
       transform(state.forwards.begin(), state.forwards.end(), myRefs.begin(),
-                perfs.begin(), [](const vector<T> &fwds, const double ref) {
+                perfs.begin(), [](const auto &fwds, const double ref) {
                   return fwds[0] / ref;
                 });
       T worst = *min_element(perfs.begin(), perfs.end());
@@ -362,7 +393,7 @@ public:
       int step = myNumPeriods - 1;
       auto &state = path[step];
       transform(state.forwards.begin(), state.forwards.end(), myRefs.begin(),
-                perfs.begin(), [](const vector<T> &fwds, const double ref) {
+                perfs.begin(), [](const auto &fwds, const double ref) {
                   return fwds[0] / ref;
                 });
       T worst = *min_element(perfs.begin(), perfs.end());
@@ -0,0 +1,232 @@
+
+/*
+Written by Antoine Savine in 2018
+
+This code is the strict IP of Antoine Savine
+
+License to use and alter this code for personal and commercial applications
+is freely granted to any person or company who purchased a copy of the book
+
+Modern Computational Finance: AAD and Parallel Simulations
+Antoine Savine
+Wiley, 2018
+
+As long as this comment is preserved at the top of the file
+*/
+
+//  Portfolio product: many products priced over one set of paths
+
+//  Wraps a collection of products on the same underlying assets into
+//      a single Product: the timelines and deflines are merged into
+//      one superset, every path is generated once by the model, and
+//      payoffs() dispatches the merged samples to each product
+//      through precomputed index maps.
+//  Since path generation dominates payoff evaluation by an order of
+//      magnitude on our books, the whole engine stack (serial,
+//      parallel, AAD) prices the book for the cost of one simulation.
+
+#pragma once
+
+#include "mcBase.h"
+
+template <class T> class PortfolioProduct : public Product<T> {
+  //  The products, owned
+  vector<unique_ptr<Product<T>>> myProducts;
+
+  //  Merged timeline and defline
+  vector<Time> myTimeline;
+  vector<SampleDef> myDefline;
+
+  //  Concatenated payoff labels
+  vector<string> myLabels;
+
+  //  Index maps from each product's view into the merged samples
+  struct ProductMap {
+    //  product event -> merged event
+    vector<size_t> events;
+    //  per product event: product data index -> merged data index
+    vector<vector<size_t>> discounts;
+    vector<vector<size_t>> libors;
+    //  per product event, per asset
+    vector<vector<vector<size_t>>> forwards;
+    //  offset of the product's payoffs in the merged vector
+    size_t firstPayoff;
+  };
+  vector<ProductMap> myMaps;
+
+  //  Find a value in a vector or append it, return its index
+  template <class V, class EQ>
+  static size_t findOrAdd(vector<V> &values, const V &value, const EQ &eq) {
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (eq(values[i], value))
+        return i;
+    }
+    values.push_back(value);
+    return values.size() - 1;
+  }
+
+public:
+  //  Constructor: clone the products, merge timelines and deflines
+  PortfolioProduct(const vector<const Product<T> *> &products) {
+    if (products.empty())
+      throw runtime_error("PortfolioProduct() : empty portfolio");
+
+    myProducts.reserve(products.size());
+    for (const auto *product : products) {
+      if (product->assetNames() != products.front()->assetNames())
+        throw runtime_error(
+            "PortfolioProduct() : products on different assets");
+      myProducts.push_back(product->clone());
+    }
+
+    const size_t nAssets = products.front()->numAssets();
+
+    //  Merged timeline = sorted union of the event dates
+    for (const auto &product : myProducts) {
+      const auto &timeline = product->timeline();
+      myTimeline.insert(myTimeline.end(), timeline.begin(), timeline.end());
+    }
+    sort(myTimeline.begin(), myTimeline.end());
+    myTimeline.erase(unique(myTimeline.begin(), myTimeline.end()),
+                     myTimeline.end());
+
+    //  Merged defline = union of the requirements on each event date
+    myDefline.resize(myTimeline.size());
+    for (auto &def : myDefline) {
+      def.numeraire = false;
+      def.forwardMats.resize(nAssets);
+    }
+
+    //  Build the union and the index maps in one pass
+    myMaps.resize(myProducts.size());
+    size_t payoffOffset = 0;
+    for (size_t p = 0; p < myProducts.size(); ++p) {
+      const auto &product = *myProducts[p];
+      const auto &timeline = product.timeline();
+      const auto &defline = product.defline();
+      ProductMap &map = myMaps[p];
+
+      map.firstPayoff = payoffOffset;
+      payoffOffset += product.payoffLabels().size();
+      const auto &labels = product.payoffLabels();
+      myLabels.insert(myLabels.end(), labels.begin(), labels.end());
+
+      const size_t nEvents = timeline.size();
+      map.events.resize(nEvents);
+      map.discounts.resize(nEvents);
+      map.libors.resize(nEvents);
+      map.forwards.resize(nEvents);
+
+      for (size_t e = 0; e < nEvents; ++e) {
+        //  Merged event index
+        const size_t m = distance(
+            myTimeline.begin(),
+            lower_bound(myTimeline.begin(), myTimeline.end(), timeline[e]));
+        map.events[e] = m;
+        SampleDef &def = myDefline[m];
+
+        def.numeraire |= defline[e].numeraire;
+
+        map.discounts[e].resize(defline[e].discountMats.size());
+        for (size_t k = 0; k < defline[e].discountMats.size(); ++k) {
+          map.discounts[e][k] =
+              findOrAdd(def.discountMats, defline[e].discountMats[k],
+                        [](const Time x, const Time y) { return x == y; });
+        }
+
+        map.libors[e].resize(defline[e].liborDefs.size());
+        for (size_t k = 0; k < defline[e].liborDefs.size(); ++k) {
+          map.libors[e][k] = findOrAdd(
+              def.liborDefs, defline[e].liborDefs[k],
+              [](const SampleDef::RateDef &x, const SampleDef::RateDef &y) {
+                return x.start == y.start && x.end == y.end &&
+                       x.curve == y.curve;
+              });
+        }
+
+        map.forwards[e].resize(nAssets);
+        for (size_t a = 0; a < defline[e].forwardMats.size(); ++a) {
+          map.forwards[e][a].resize(defline[e].forwardMats[a].size());
+          for (size_t k = 0; k < defline[e].forwardMats[a].size(); ++k) {
+            map.forwards[e][a][k] =
+                findOrAdd(def.forwardMats[a], defline[e].forwardMats[a][k],
+                          [](const Time x, const Time y) { return x == y; });
+          }
+        }
+      }
+    }
+  }
+
+  //  Copy: re-clone the products, the maps and merged data are copied
+  PortfolioProduct(const PortfolioProduct &rhs)
+      : myTimeline(rhs.myTimeline), myDefline(rhs.myDefline),
+        myLabels(rhs.myLabels), myMaps(rhs.myMaps) {
+    myProducts.reserve(rhs.myProducts.size());
+    for (const auto &product : rhs.myProducts) {
+      myProducts.push_back(product->clone());
+    }
+  }
+
+  //  Virtual copy constructor
+  unique_ptr<Product<T>> clone() const override {
+    return make_unique<PortfolioProduct<T>>(*this);
+  }
+
+  //  Assets, from the (identical) products
+  const size_t numAssets() const override { return myProducts[0]->numAssets(); }
+  const vector<string> &assetNames() const override {
+    return myProducts[0]->assetNames();
+  }
+
+  //  Timeline
+  const vector<Time> &timeline() const override { return myTimeline; }
+
+  //  Defline
+  const vector<SampleDef> &defline() const override { return myDefline; }
+
+  //  Labels, concatenated over the products
+  const vector<string> &payoffLabels() const override { return myLabels; }
+
+  //  Payoffs: dispatch the merged samples to every product
+  void payoffs(
+      //  path on the merged timeline
+      const Scenario<T> &path,
+      //  pre-allocated space, all the products' payoffs concatenated
+      vector<T> &payoffs) const override {
+    //  Per-thread workspaces, rebound on every call:
+    //      cheap (index wiring only) and safe across
+    //      portfolio instances and parallel engines
+    static thread_local vector<Scenario<T>> ws;
+    static thread_local vector<T> prdPayoffs;
+    ws.resize(myProducts.size());
+
+    for (size_t p = 0; p < myProducts.size(); ++p) {
+      const auto &product = *myProducts[p];
+      const ProductMap &map = myMaps[p];
+      Scenario<T> &prdPath = ws[p];
+      allocatePath(product.defline(), prdPath);
+
+      //  Gather this product's samples from the merged path
+      const size_t nEvents = map.events.size();
+      for (size_t e = 0; e < nEvents; ++e) {
+        const Sample<T> &src = path[map.events[e]];
+        Sample<T> &dst = prdPath[e];
+
+        dst.numeraire = src.numeraire;
+        for (size_t k = 0; k < map.discounts[e].size(); ++k)
+          dst.discounts[k] = src.discounts[map.discounts[e][k]];
+        for (size_t k = 0; k < map.libors[e].size(); ++k)
+          dst.libors[k] = src.libors[map.libors[e][k]];
+        for (size_t a = 0; a < map.forwards[e].size(); ++a)
+          for (size_t k = 0; k < map.forwards[e][a].size(); ++k)
+            dst.forwards[a][k] = src.forwards[a][map.forwards[e][a][k]];
+      }
+
+      //  Evaluate and write into the product's slice
+      prdPayoffs.resize(product.payoffLabels().size());
+      product.payoffs(prdPath, prdPayoffs);
+      copy(prdPayoffs.begin(), prdPayoffs.end(),
+           payoffs.begin() + map.firstPayoff);
+    }
+  }
+};
@@ -0,0 +1,142 @@
+
+/*
+Written by Antoine Savine in 2018
+
+This code is the strict IP of Antoine Savine
+
+License to use and alter this code for personal and commercial applications
+is freely granted to any person or company who purchased a copy of the book
+
+Modern Computational Finance: AAD and Parallel Simulations
+Antoine Savine
+Wiley, 2018
+
+As long as this comment is preserved at the top of the file
+*/
+
+#pragma once
+
+//  Opt-in phase instrumentation of the simulation engines
+//
+//  Build with -DMCPROFILE to enable: the engines then accumulate
+//      per-thread wall time for each phase (setup, random numbers,
+//      path generation, payoffs, adjoint propagation, final
+//      propagation), readable with mcProfileTotals() / mcProfileReport()
+//      and cleared with mcProfileReset().
+//  Without MCPROFILE the scope macro expands to nothing and the
+//      engines carry no instrumentation at all.
+
+#ifdef MCPROFILE
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+//  The phases
+enum McPhase {
+  mcPhaseSetup = 0,
+  mcPhaseRng,
+  mcPhasePath,
+  mcPhasePayoffs,
+  mcPhasePropagate,
+  mcPhaseFinal,
+  mcNumPhases
+};
+
+inline const char *mcPhaseName(const size_t p) {
+  static const char *names[mcNumPhases] = {"setup",   "rng",       "path",
+                                           "payoffs", "propagate", "final"};
+  return names[p];
+}
+
+namespace mcProfileImpl {
+
+//  Global totals, guarded; per-thread counters flush here
+//      on thread exit and on demand
+inline mutex &theMutex() {
+  static mutex m;
+  return m;
+}
+inline array<unsigned long long, mcNumPhases> &theTotals() {
+  static array<unsigned long long, mcNumPhases> totals{};
+  return totals;
+}
+
+struct ThreadCounters {
+  array<unsigned long long, mcNumPhases> ns{};
+
+  //  Flush into the global totals
+  void flush() {
+    lock_guard<mutex> lk(theMutex());
+    auto &totals = theTotals();
+    for (size_t p = 0; p < mcNumPhases; ++p) {
+      totals[p] += ns[p];
+      ns[p] = 0;
+    }
+  }
+
+  ~ThreadCounters() { flush(); }
+};
+
+inline ThreadCounters &local() {
+  static thread_local ThreadCounters counters;
+  return counters;
+}
+
+//  RAII scope timer
+struct ScopeTimer {
+  const size_t phase;
+  const chrono::high_resolution_clock::time_point start;
+
+  ScopeTimer(const size_t p)
+      : phase(p), start(chrono::high_resolution_clock::now()) {}
+  ~ScopeTimer() {
+    local().ns[phase] += chrono::duration_cast<chrono::nanoseconds>(
+                             chrono::high_resolution_clock::now() - start)
+                             .count();
+  }
+};
+
+} //  namespace mcProfileImpl
+
+//  Totals in nanoseconds per phase
+//  Note: pool threads flush on exit; the calling thread
+//      flushes its own counters here
+inline array<unsigned long long, mcNumPhases> mcProfileTotals() {
+  mcProfileImpl::local().flush();
+  lock_guard<mutex> lk(mcProfileImpl::theMutex());
+  return mcProfileImpl::theTotals();
+}
+
+inline void mcProfileReset() {
+  mcProfileImpl::local().flush();
+  lock_guard<mutex> lk(mcProfileImpl::theMutex());
+  mcProfileImpl::theTotals().fill(0);
+}
+
+inline void mcProfileReport() {
+  const auto totals = mcProfileTotals();
+  unsigned long long all = 0;
+  for (const auto t : totals)
+    all += t;
+  printf("%-12s %12s %8s\n", "phase", "ms", "share");
+  for (size_t p = 0; p < mcNumPhases; ++p) {
+    printf("%-12s %12.1f %7.1f%%\n", mcPhaseName(p), totals[p] * 1.0e-6,
+           all ? 100.0 * totals[p] / all : 0.0);
+  }
+}
+
+#define MCPROFILE_PASTE2(a, b) a##b
+#define MCPROFILE_PASTE(a, b) MCPROFILE_PASTE2(a, b)
+#define MCPROFILE_SCOPE(phase)                                                 \
+  mcProfileImpl::ScopeTimer MCPROFILE_PASTE(mcProfScope, __LINE__)(phase)
+
+#else
+
+//  Disabled: no instrumentation compiled into the engines
+#define MCPROFILE_SCOPE(phase)
+
+#endif
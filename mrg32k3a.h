@@ -153,6 +153,30 @@ public:
     }
   }
 
+  //  Batched: uniforms are generated one row at a time,
+  //      the Gaussian transformation is vectorized over the whole row
+  //  Antithetic logic matches nextG exactly
+  void nextGBlock(matrix<double> &gaussMat, const size_t nPoints) override {
+    static thread_local vector<double> uVec;
+    uVec.resize(myDim);
+
+    for (size_t p = 0; p < nPoints; ++p) {
+      double *row = gaussMat[p];
+      if (myAnti) {
+        //	Do not generate, negate cached
+        transform(myCachedGaussians.begin(), myCachedGaussians.end(), row,
+                  [](const double n) { return -n; });
+        myAnti = false;
+      } else {
+        //	Generate uniforms, transform the whole row, cache
+        generate(uVec.begin(), uVec.end(), [this]() { return nextNumber(); });
+        invNormalCdfBlock(uVec.data(), row, myDim);
+        copy(row, row + myDim, myCachedGaussians.begin());
+        myAnti = true;
+      }
+    }
+  }
+
   //	Skip ahead logic
   //	See chapter 7
   //	To avoid overflow, we nest mods in innermost results
@@ -0,0 +1,147 @@
+
+/*
+Written by Antoine Savine in 2018
+
+This code is the strict IP of Antoine Savine
+
+License to use and alter this code for personal and commercial applications
+is freely granted to any person or company who purchased a copy of the book
+
+Modern Computational Finance: AAD and Parallel Simulations
+Antoine Savine
+Wiley, 2018
+
+As long as this comment is preserved at the top of the file
+*/
+
+#pragma once
+
+//  Counter based RNG: Philox4x32-10
+//  (Salmon, Moraes, Dror, Shaw, Parallel Random Numbers:
+//      As Easy as 1, 2, 3, SC'11)
+
+//  Each draw is a pure function of (key, counter): skipping to any
+//      point of the sequence is just setting the counter, so the
+//      parallel engines' skipTo at every batch boundary is free and
+//      batch shapes may be chosen arbitrarily.
+//  The generation itself is a few rounds of 32x32 multiplies and
+//      XORs per 4 draws, with no sequential state to carry.
+
+#include "gaussians.h"
+#include "mcBase.h"
+
+class Philox : public RNG {
+  //  Key, from the seeds
+  unsigned myKey0, myKey1;
+
+  //  Dimension
+  size_t myDim;
+
+  //  Next point in the sequence
+  unsigned long long myPoint;
+
+  //  Number of 4-draw blocks per point
+  size_t myBlocks;
+
+  //  Philox4x32 round constants
+  static constexpr unsigned M0 = 0xD2511F53;
+  static constexpr unsigned M1 = 0xCD9E8D57;
+  static constexpr unsigned W0 = 0x9E3779B9;
+  static constexpr unsigned W1 = 0xBB67AE85;
+
+  //	We divide by 2^32 + 1 so we never hit 0 or 1
+  static constexpr double ONEOVER2POW32P1 = 2.3283064365386963e-10;
+
+  //  One Philox4x32-10 block: 4 words out of the counter and key
+  static void philox4x32(const unsigned ctr[4], unsigned key0, unsigned key1,
+                         unsigned out[4]) {
+    unsigned c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+
+    for (int round = 0; round < 10; ++round) {
+      //  Two 32x32 -> 64 multiplies
+      const unsigned long long p0 = (unsigned long long)M0 * c0;
+      const unsigned long long p1 = (unsigned long long)M1 * c2;
+
+      const unsigned hi0 = unsigned(p0 >> 32), lo0 = unsigned(p0);
+      const unsigned hi1 = unsigned(p1 >> 32), lo1 = unsigned(p1);
+
+      //  Permute and mix with the key
+      const unsigned n0 = hi1 ^ c1 ^ key0;
+      const unsigned n1 = lo1;
+      const unsigned n2 = hi0 ^ c3 ^ key1;
+      const unsigned n3 = lo0;
+
+      c0 = n0;
+      c1 = n1;
+      c2 = n2;
+      c3 = n3;
+
+      //  Bump the key (Weyl sequence)
+      key0 += W0;
+      key1 += W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+  //  Fill one point's uniforms
+  void fillUniforms(const unsigned long long point, double *uVec) {
+    unsigned ctr[4], out[4];
+    //  Counter = (block within point, 0, point low, point high)
+    ctr[1] = 0;
+    ctr[2] = unsigned(point);
+    ctr[3] = unsigned(point >> 32);
+
+    size_t j = 0;
+    for (size_t block = 0; block < myBlocks; ++block) {
+      ctr[0] = unsigned(block);
+      philox4x32(ctr, myKey0, myKey1, out);
+      for (size_t lane = 0; lane < 4 && j < myDim; ++lane, ++j) {
+        uVec[j] = (out[lane] + 0.5) * ONEOVER2POW32P1;
+      }
+    }
+  }
+
+public:
+  //  Constructor with seeds, the key of the whole sequence
+  Philox(const unsigned seed1 = 12345, const unsigned seed2 = 1234)
+      : myKey0(seed1), myKey1(seed2), myDim(0), myPoint(0), myBlocks(0) {}
+
+  //  Virtual copy constructor
+  unique_ptr<RNG> clone() const override { return make_unique<Philox>(*this); }
+
+  //  Initializer
+  void init(const size_t simDim) override {
+    myDim = simDim;
+    myBlocks = (myDim + 3) / 4;
+    myPoint = 0;
+  }
+
+  void nextU(vector<double> &uVec) override {
+    fillUniforms(myPoint++, uVec.data());
+  }
+
+  void nextG(vector<double> &gaussVec) override {
+    static thread_local vector<double> uVec;
+    uVec.resize(myDim);
+    fillUniforms(myPoint++, uVec.data());
+    invNormalCdfBlock(uVec.data(), gaussVec.data(), myDim);
+  }
+
+  //  Batched: vectorized Gaussian transformation per row
+  void nextGBlock(matrix<double> &gaussMat, const size_t nPoints) override {
+    static thread_local vector<double> uVec;
+    uVec.resize(myDim);
+
+    for (size_t p = 0; p < nPoints; ++p) {
+      fillUniforms(myPoint++, uVec.data());
+      invNormalCdfBlock(uVec.data(), gaussMat[p], myDim);
+    }
+  }
+
+  //  Skip ahead: O(1), the counter IS the position
+  void skipTo(const unsigned b) override { myPoint = b; }
+};
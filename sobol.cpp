@@ -3666,7 +3666,129 @@ const unsigned * const jkDir[32] = {
     jkDir32 };
 
 
+//  Binary direction number file
+//  ============================
+//  Layout: 4 unsigned header words { magic, version, nDirs, nDim }
+//      followed by nDirs * nDim direction numbers, row (direction) major
+//  Memory mapping the file shares the read-only pages
+//      across all the pricing processes on a host
+//      and keeps the compiled-in table out of resident memory
+
+#include "sobol.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr unsigned SOBOL_FILE_MAGIC = 0x4C424F53;  //  "SOBL"
+constexpr unsigned SOBOL_FILE_VERSION = 1;
+
+//  The mapped table, when a file is loaded
+const unsigned* mappedBase = nullptr;   //  mapped image, header included
+size_t mappedBytes = 0;
+const unsigned* mappedJkDir[SOBOL_DIR_COUNT];
+
+}  //  namespace
+
+//  Write the compiled-in table into a compact binary file
+bool sobolWriteDirectionFile(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    const unsigned header[4] = { SOBOL_FILE_MAGIC, SOBOL_FILE_VERSION,
+        unsigned(SOBOL_DIR_COUNT), unsigned(SOBOL_MAX_DIM) };
+    bool ok = fwrite(header, sizeof(unsigned), 4, f) == 4;
+    for (size_t i = 0; ok && i < SOBOL_DIR_COUNT; ++i)
+    {
+        ok = fwrite(jkDir[i], sizeof(unsigned), SOBOL_MAX_DIM, f) 
+            == SOBOL_MAX_DIM;
+    }
+
+    fclose(f);
+    return ok;
+}
+
+//  Memory map a direction number file,
+//      returns false and keeps the compiled-in table on any failure
+bool sobolMapDirectionFile(const std::string& path)
+{
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    const size_t expected 
+        = (4 + SOBOL_DIR_COUNT * SOBOL_MAX_DIM) * sizeof(unsigned);
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) != expected)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* image = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    //  The mapping keeps its own reference on the file
+    close(fd);
+    if (image == MAP_FAILED) return false;
+
+    const unsigned* words = static_cast<const unsigned*>(image);
+    if (words[0] != SOBOL_FILE_MAGIC || words[1] != SOBOL_FILE_VERSION
+        || words[2] != SOBOL_DIR_COUNT || words[3] != SOBOL_MAX_DIM)
+    {
+        munmap(image, expected);
+        return false;
+    }
+
+    //  Release a previous mapping, if any
+    sobolUnmapDirectionFile();
+
+    mappedBase = words;
+    mappedBytes = expected;
+    for (size_t i = 0; i < SOBOL_DIR_COUNT; ++i)
+    {
+        mappedJkDir[i] = words + 4 + i * SOBOL_MAX_DIM;
+    }
+
+    return true;
+#else
+    //  No mapping on this platform, compiled-in table only
+    (void) path;
+    return false;
+#endif
+}
+
+//  Release the mapping, back to the compiled-in table
+void sobolUnmapDirectionFile()
+{
+#ifndef _WIN32
+    if (mappedBase)
+    {
+        munmap(const_cast<unsigned*>(mappedBase), mappedBytes);
+        mappedBase = nullptr;
+        mappedBytes = 0;
+    }
+#endif
+}
+
 const unsigned * const * getjkDir()
 {
-    return jkDir;
+    //  On first use, map the file named by SOBOL_DIRECTION_FILE if set,
+    //      fall back on the compiled-in table otherwise
+    static const bool envTried = []()
+    {
+        const char* path = getenv("SOBOL_DIRECTION_FILE");
+        return path ? sobolMapDirectionFile(path) : false;
+    }();
+    (void) envTried;
+
+    return mappedBase ? mappedJkDir : jkDir;
 }
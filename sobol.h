@@ -25,8 +25,24 @@ As long as this comment is preserved at the top of the file
 
 #define ONEOVER2POW32 2.3283064365387E-10
 
+//  Dimension of the direction number table in sobol.cpp
+constexpr size_t SOBOL_DIR_COUNT = 32;   //  direction numbers per dimension
+constexpr size_t SOBOL_MAX_DIM = 1111;   //  dimensions
+
+//  Direction numbers: the memory mapped table when one is loaded,
+//      the compiled-in table in sobol.cpp otherwise
 const unsigned *const *getjkDir();
 
+//  Binary direction number file support, see sobol.cpp
+//  Write the compiled-in table into a compact binary file
+bool sobolWriteDirectionFile(const string &path);
+//  Memory map a binary file written by sobolWriteDirectionFile
+//      so the read-only pages are shared across processes,
+//      returns false (and keeps the compiled-in table) on failure
+bool sobolMapDirectionFile(const string &path);
+//  Release the mapping, back to the compiled-in table
+void sobolUnmapDirectionFile();
+
 class Sobol : public RNG {
   //  Dimension
   size_t myDim;
@@ -102,6 +118,49 @@ public:
         [](const unsigned long i) { return invNormalCdf(ONEOVER2POW32 * i); });
   }
 
+  //  Batched, dimension major: each dimension's XOR recurrence runs
+  //      across the whole block of points in one tight loop,
+  //      turning the per-point state scatter into streaming writes,
+  //      and the Gaussian transformation consumes contiguous lanes
+  //  State and index after the call are identical
+  //      to nPoints successive next() calls
+  void nextGBlock(matrix<double> &gaussMat, const size_t nPoints) override {
+    //  Gray code positions for the whole block
+    static thread_local vector<unsigned> dirIdx;
+    dirIdx.resize(nPoints);
+    for (size_t p = 0; p < nPoints; ++p) {
+      unsigned n = myIndex + unsigned(p), j = 0;
+      while (n & 1) {
+        n >>= 1;
+        ++j;
+      }
+      dirIdx[p] = j;
+    }
+
+    //  One dimension at a time over all the points
+    static thread_local vector<double> uRow, gRow;
+    uRow.resize(nPoints);
+    gRow.resize(nPoints);
+
+    for (size_t k = 0; k < myDim; ++k) {
+      unsigned x = myState[k];
+      for (size_t p = 0; p < nPoints; ++p) {
+        x ^= jkDir[dirIdx[p]][k];
+        uRow[p] = ONEOVER2POW32 * x;
+      }
+      myState[k] = x;
+
+      //  Vectorized Gaussian transformation of the contiguous lane,
+      //      then transpose into the row major output
+      invNormalCdfBlock(uRow.data(), gRow.data(), nPoints);
+      for (size_t p = 0; p < nPoints; ++p) {
+        gaussMat[p][k] = gRow[p];
+      }
+    }
+
+    myIndex += unsigned(nPoints);
+  }
+
   //  Skip ahead (from 0 to b)
   void skipTo(const unsigned b) override {
     //	Check skip
@@ -112,8 +171,12 @@ public:
     reset();
 
     //	The actual Sobol skipping algo
-    unsigned im = b;
-    unsigned two_i = 1, two_i_plus_one = 2;
+    //	64 bit arithmetic: with 32 bit counters, skips of 2^31 or
+    //	more wrapped two_i_plus_one to zero (division by zero) and
+    //	overflowed im + two_i - the multilevel and sharded engines
+    //	legitimately position that deep into the sequence
+    const unsigned long long im = b;
+    unsigned long long two_i = 1, two_i_plus_one = 2;
 
     unsigned i = 0;
     while (two_i <= im) {
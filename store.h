@@ -23,30 +23,156 @@ As long as this comment is preserved at the top of the file
 #include "mcMdl.h"
 #include "mcPrd.h"
 #include "mcPrdMulti.h"
+#include "mcPrdPortfolio.h"
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <tuple>
 #include <unordered_map>
 
 using namespace std;
 
+//  Each entry carries three instantiations:
+//      double for valuation, Number for risk,
+//      float for the single precision pricing mode
 using ModelStore =
     unordered_map<string,
-                  pair<unique_ptr<Model<double>>, unique_ptr<Model<Number>>>>;
-using ProductStore = unordered_map<
-    string, pair<unique_ptr<Product<double>>, unique_ptr<Product<Number>>>>;
+                  tuple<unique_ptr<Model<double>>, unique_ptr<Model<Number>>,
+                        unique_ptr<Model<float>>>>;
+using ProductStore =
+    unordered_map<string,
+                  tuple<unique_ptr<Product<double>>, unique_ptr<Product<Number>>,
+                        unique_ptr<Product<float>>>>;
 
 ModelStore modelStore;
 ProductStore productStore;
 
+//  Binary store snapshots
+//  ======================
+//  Every put* call below appends a compact binary record of its
+//      arguments to a creation log; saveStore dumps the log to a
+//      file and loadStore replays it, reconstituting the exact same
+//      models and products (including all three instantiations)
+//      without re-deriving anything at the call site.
+//  The objects themselves hold vtables and derived state, so the
+//      snapshot stores the creation inputs rather than raw images;
+//      replay is dominated by the model constructors and is orders
+//      of magnitude faster than re-running the booking layer.
+
+namespace snapshotImpl {
+
+//  Record tags
+enum RecordTag : unsigned char {
+  tagBlackScholes = 1,
+  tagDupire,
+  tagDisplaced,
+  tagEuropean,
+  tagBarrier,
+  tagContingent,
+  tagEuropeans,
+  tagMultiStats,
+  tagBaskets,
+  tagAutocall,
+  tagPortfolio
+};
+
+//  The creation log
+inline vector<pair<unsigned char, string>> &theLog() {
+  static vector<pair<unsigned char, string>> log;
+  return log;
+}
+inline bool &replaying() {
+  static bool flag = false;
+  return flag;
+}
+
+//  Binary writers into a string buffer
+template <class POD> void put(string &buf, const POD &x) {
+  buf.append(reinterpret_cast<const char *>(&x), sizeof(POD));
+}
+inline void put(string &buf, const string &s) {
+  put(buf, s.size());
+  buf.append(s);
+}
+template <class T> void put(string &buf, const vector<T> &v) {
+  put(buf, v.size());
+  for (const auto &x : v)
+    put(buf, x);
+}
+inline void put(string &buf, const matrix<double> &m) {
+  put(buf, m.rows());
+  put(buf, m.cols());
+  for (const double x : m)
+    put(buf, x);
+}
+
+//  Binary readers, bounds checked so truncated snapshots
+//      fail cleanly instead of overreading
+inline void need(const string &buf, const size_t pos, const size_t bytes) {
+  if (pos + bytes > buf.size())
+    throw runtime_error("loadStore() : truncated snapshot");
+}
+template <class POD> void get(const string &buf, size_t &pos, POD &x) {
+  need(buf, pos, sizeof(POD));
+  memcpy(&x, buf.data() + pos, sizeof(POD));
+  pos += sizeof(POD);
+}
+inline void get(const string &buf, size_t &pos, string &s) {
+  size_t n;
+  get(buf, pos, n);
+  need(buf, pos, n);
+  s.assign(buf, pos, n);
+  pos += n;
+}
+template <class T> void get(const string &buf, size_t &pos, vector<T> &v) {
+  size_t n;
+  get(buf, pos, n);
+  v.resize(n);
+  for (auto &x : v)
+    get(buf, pos, x);
+}
+inline void get(const string &buf, size_t &pos, matrix<double> &m) {
+  size_t rows, cols;
+  get(buf, pos, rows);
+  get(buf, pos, cols);
+  m.resize(rows, cols);
+  for (auto &x : m)
+    get(buf, pos, x);
+}
+
+//  Append a record, unless we are replaying one
+inline void log(const unsigned char tag, const string &blob) {
+  if (!replaying())
+    theLog().push_back(make_pair(tag, blob));
+}
+
+} //  namespace snapshotImpl
+
 void putBlackScholes(const double spot, const double vol, const bool qSpot,
                      const double rate, const double div, const string &store) {
-  //  We create 2 models, one for valuation and one for risk
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, spot);
+    put(blob, vol);
+    put(blob, qSpot);
+    put(blob, rate);
+    put(blob, div);
+    put(blob, store);
+    log(tagBlackScholes, blob);
+  }
+
+  //  We create 3 models: valuation, risk, single precision
   unique_ptr<Model<double>> mdl =
       make_unique<BlackScholes<double>>(spot, vol, qSpot, rate, div);
   unique_ptr<Model<Number>> riskMdl =
       make_unique<BlackScholes<Number>>(spot, vol, qSpot, rate, div);
+  unique_ptr<Model<float>> fltMdl =
+      make_unique<BlackScholes<float>>(spot, vol, qSpot, rate, div);
 
   //  And move them into the map
-  modelStore[store] = make_pair(std::move(mdl), std::move(riskMdl));
+  modelStore[store] =
+      make_tuple(std::move(mdl), std::move(riskMdl), std::move(fltMdl));
 }
 
 void putDupire(const double spot, const vector<double> &spots,
@@ -54,14 +180,29 @@ void putDupire(const double spot, const vector<double> &spots,
                //  spot major
                const matrix<double> &vols, const double maxDt,
                const string &store) {
-  //  We create 2 models, one for valuation and one for risk
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, spot);
+    put(blob, spots);
+    put(blob, times);
+    put(blob, vols);
+    put(blob, maxDt);
+    put(blob, store);
+    log(tagDupire, blob);
+  }
+
+  //  We create 3 models: valuation, risk, single precision
   unique_ptr<Model<double>> mdl =
       make_unique<Dupire<double>>(spot, spots, times, vols, maxDt);
   unique_ptr<Model<Number>> riskMdl =
       make_unique<Dupire<Number>>(spot, spots, times, vols, maxDt);
+  unique_ptr<Model<float>> fltMdl =
+      make_unique<Dupire<float>>(spot, spots, times, vols, maxDt);
 
   //  And move them into the map
-  modelStore[store] = make_pair(std::move(mdl), std::move(riskMdl));
+  modelStore[store] =
+      make_tuple(std::move(mdl), std::move(riskMdl), std::move(fltMdl));
 }
 
 void putDisplaced(const vector<string> &assets, const vector<double> &spots,
@@ -70,16 +211,37 @@ void putDisplaced(const vector<string> &assets, const vector<double> &spots,
                   const vector<Time> &divDates, const matrix<double> &divs,
                   const matrix<double> &correl, const double &lambda,
                   const string &store) {
-  //  We create 2 models, one for valuation and one for risk
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, assets);
+    put(blob, spots);
+    put(blob, atms);
+    put(blob, skews);
+    put(blob, discRate);
+    put(blob, repoSpreads);
+    put(blob, divDates);
+    put(blob, divs);
+    put(blob, correl);
+    put(blob, lambda);
+    put(blob, store);
+    log(tagDisplaced, blob);
+  }
+
+  //  We create 3 models: valuation, risk, single precision
   unique_ptr<Model<double>> mdl = make_unique<MultiDisplaced<double>>(
       assets, discRate, repoSpreads, spots, divDates, divs, atms, skews, correl,
       lambda);
   unique_ptr<Model<Number>> riskMdl = make_unique<MultiDisplaced<Number>>(
       assets, discRate, repoSpreads, spots, divDates, divs, atms, skews, correl,
       lambda);
+  unique_ptr<Model<float>> fltMdl = make_unique<MultiDisplaced<float>>(
+      assets, discRate, repoSpreads, spots, divDates, divs, atms, skews, correl,
+      lambda);
 
   //  And move them into the map
-  modelStore[store] = make_pair(std::move(mdl), std::move(riskMdl));
+  modelStore[store] =
+      make_tuple(std::move(mdl), std::move(riskMdl), std::move(fltMdl));
 }
 
 template <class T> const Model<T> *getModel(const string &store);
@@ -89,7 +251,7 @@ template <> const Model<double> *getModel(const string &store) {
   if (it == modelStore.end())
     return nullptr;
   else
-    return it->second.first.get();
+    return get<0>(it->second).get();
 }
 
 template <> const Model<Number> *getModel(const string &store) {
@@ -97,7 +259,15 @@ template <> const Model<Number> *getModel(const string &store) {
   if (it == modelStore.end())
     return nullptr;
   else
-    return it->second.second.get();
+    return get<1>(it->second).get();
+}
+
+template <> const Model<float> *getModel(const string &store) {
+  auto it = modelStore.find(store);
+  if (it == modelStore.end())
+    return nullptr;
+  else
+    return get<2>(it->second).get();
 }
 
 pair<const vector<string> *, const vector<double *> *>
@@ -106,58 +276,101 @@ getModelParameters(const string &store) {
   if (it == modelStore.end())
     return make_pair(nullptr, nullptr);
   else {
-    auto *mdl = it->second.first.get();
+    auto *mdl = get<0>(it->second).get();
     return make_pair(&mdl->parameterLabels(), &mdl->parameters());
   }
 }
 
 void putEuropean(const double strike, const Time exerciseDate,
                  const Time settlementDate, const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, strike);
+    put(blob, exerciseDate);
+    put(blob, settlementDate);
+    put(blob, store);
+    log(tagEuropean, blob);
+  }
+
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd =
-      make_unique<European<double>>(strike, exerciseDate, settlementDate);
-  unique_ptr<Product<Number>> riskPrd =
-      make_unique<European<Number>>(strike, exerciseDate, settlementDate);
+  unique_ptr<Product<double>> prd = make_unique<European<double>>(strike, exerciseDate, settlementDate);
+  unique_ptr<Product<Number>> riskPrd = make_unique<European<Number>>(strike, exerciseDate, settlementDate);
+  unique_ptr<Product<float>> fltPrd = make_unique<European<float>>(strike, exerciseDate, settlementDate);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putBarrier(const double strike, const double barrier, const Time maturity,
                 const double monitorFreq, const double smooth,
                 const bool callPut, //	false: call, true: put
                 const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, strike);
+    put(blob, barrier);
+    put(blob, maturity);
+    put(blob, monitorFreq);
+    put(blob, smooth);
+    put(blob, callPut);
+    put(blob, store);
+    log(tagBarrier, blob);
+  }
+
   const double smoothFactor = smooth <= 0 ? EPS : smooth;
 
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd = make_unique<UOC<double>>(
-      strike, barrier, maturity, monitorFreq, smoothFactor, callPut);
-  unique_ptr<Product<Number>> riskPrd = make_unique<UOC<Number>>(
-      strike, barrier, maturity, monitorFreq, smoothFactor, callPut);
+  unique_ptr<Product<double>> prd = make_unique<UOC<double>>(strike, barrier, maturity, monitorFreq, smoothFactor, callPut);
+  unique_ptr<Product<Number>> riskPrd = make_unique<UOC<Number>>(strike, barrier, maturity, monitorFreq, smoothFactor, callPut);
+  unique_ptr<Product<float>> fltPrd = make_unique<UOC<float>>(strike, barrier, maturity, monitorFreq, smoothFactor, callPut);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putContingent(const double coupon, const Time maturity,
                    const double payFreq, const double smooth,
                    const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, coupon);
+    put(blob, maturity);
+    put(blob, payFreq);
+    put(blob, smooth);
+    put(blob, store);
+    log(tagContingent, blob);
+  }
+
   const double smoothFactor = smooth <= 0 ? 0.0 : smooth;
 
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd = make_unique<ContingentBond<double>>(
-      maturity, coupon, payFreq, smoothFactor);
-  unique_ptr<Product<Number>> riskPrd = make_unique<ContingentBond<Number>>(
-      maturity, coupon, payFreq, smoothFactor);
+  unique_ptr<Product<double>> prd = make_unique<ContingentBond<double>>(maturity, coupon, payFreq, smoothFactor);
+  unique_ptr<Product<Number>> riskPrd = make_unique<ContingentBond<Number>>(maturity, coupon, payFreq, smoothFactor);
+  unique_ptr<Product<float>> fltPrd = make_unique<ContingentBond<float>>(maturity, coupon, payFreq, smoothFactor);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putEuropeans(
     //  maturities must be given in increasing order
     const vector<Time> &maturities, const vector<double> &strikes,
     const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, maturities);
+    put(blob, strikes);
+    put(blob, store);
+    log(tagEuropeans, blob);
+  }
+
   //  Create map
   map<Time, vector<double>> options;
   for (size_t i = 0; i < maturities.size(); ++i) {
@@ -167,9 +380,11 @@ void putEuropeans(
   //  We create 2 products, one for valuation and one for risk
   unique_ptr<Product<double>> prd = make_unique<Europeans<double>>(options);
   unique_ptr<Product<Number>> riskPrd = make_unique<Europeans<Number>>(options);
+  unique_ptr<Product<float>> fltPrd = make_unique<Europeans<float>>(options);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putMultiStats(const vector<string> &assets,
@@ -178,51 +393,88 @@ void putMultiStats(const vector<string> &assets,
                    //  corresponding fwd dates must be on or after fixing
                    //  must have same number of fix and fwd dates
                    const vector<Time> &fwdDates, const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, assets);
+    put(blob, fixDates);
+    put(blob, fwdDates);
+    put(blob, store);
+    log(tagMultiStats, blob);
+  }
+
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd =
-      make_unique<MultiStats<double>>(assets, fixDates, fwdDates);
-  unique_ptr<Product<Number>> riskPrd =
-      make_unique<MultiStats<Number>>(assets, fixDates, fwdDates);
+  unique_ptr<Product<double>> prd = make_unique<MultiStats<double>>(assets, fixDates, fwdDates);
+  unique_ptr<Product<Number>> riskPrd = make_unique<MultiStats<Number>>(assets, fixDates, fwdDates);
+  unique_ptr<Product<float>> fltPrd = make_unique<MultiStats<float>>(assets, fixDates, fwdDates);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putBaskets(const vector<string> &assets, const vector<double> &weights,
                 const Time maturity, const vector<double> strikes,
                 const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, assets);
+    put(blob, weights);
+    put(blob, maturity);
+    put(blob, strikes);
+    put(blob, store);
+    log(tagBaskets, blob);
+  }
+
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd =
-      make_unique<Baskets<double>>(assets, weights, maturity, strikes);
-  unique_ptr<Product<Number>> riskPrd =
-      make_unique<Baskets<Number>>(assets, weights, maturity, strikes);
+  unique_ptr<Product<double>> prd = make_unique<Baskets<double>>(assets, weights, maturity, strikes);
+  unique_ptr<Product<Number>> riskPrd = make_unique<Baskets<Number>>(assets, weights, maturity, strikes);
+  unique_ptr<Product<float>> fltPrd = make_unique<Baskets<float>>(assets, weights, maturity, strikes);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 void putAutocall(const vector<string> &assets, const vector<double> &refs,
                  const Time maturity, const int periods, const double ko,
                  const double strike, const double cpn, const double smooth,
                  const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, assets);
+    put(blob, refs);
+    put(blob, maturity);
+    put(blob, periods);
+    put(blob, ko);
+    put(blob, strike);
+    put(blob, cpn);
+    put(blob, smooth);
+    put(blob, store);
+    log(tagAutocall, blob);
+  }
+
   //  We create 2 products, one for valuation and one for risk
-  unique_ptr<Product<double>> prd = make_unique<Autocall<double>>(
-      assets, refs, maturity, periods, ko, strike, cpn, smooth);
-  unique_ptr<Product<Number>> riskPrd = make_unique<Autocall<Number>>(
-      assets, refs, maturity, periods, ko, strike, cpn, smooth);
+  unique_ptr<Product<double>> prd = make_unique<Autocall<double>>(assets, refs, maturity, periods, ko, strike, cpn, smooth);
+  unique_ptr<Product<Number>> riskPrd = make_unique<Autocall<Number>>(assets, refs, maturity, periods, ko, strike, cpn, smooth);
+  unique_ptr<Product<float>> fltPrd = make_unique<Autocall<float>>(assets, refs, maturity, periods, ko, strike, cpn, smooth);
 
   //  And move them into the map
-  productStore[store] = make_pair(std::move(prd), std::move(riskPrd));
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
 }
 
 template <class T> const Product<T> *getProduct(const string &store);
 
+
 template <> const Product<double> *getProduct(const string &store) {
   auto it = productStore.find(store);
   if (it == productStore.end())
     return nullptr;
   else
-    return it->second.first.get();
+    return get<0>(it->second).get();
 }
 
 template <> const Product<Number> *getProduct(const string &store) {
@@ -230,7 +482,263 @@ template <> const Product<Number> *getProduct(const string &store) {
   if (it == productStore.end())
     return nullptr;
   else
-    return it->second.second.get();
+    return get<1>(it->second).get();
+}
+
+template <> const Product<float> *getProduct(const string &store) {
+  auto it = productStore.find(store);
+  if (it == productStore.end())
+    return nullptr;
+  else
+    return get<2>(it->second).get();
+}
+
+//  Wrap registered products sharing the same assets into one
+//      portfolio product, priced over a single set of paths
+void putPortfolio(const vector<string> &productIds, const string &store) {
+  {
+    string blob;
+    using namespace snapshotImpl;
+    put(blob, productIds);
+    put(blob, store);
+    log(tagPortfolio, blob);
+  }
+
+  vector<const Product<double> *> prds;
+  vector<const Product<Number> *> riskPrds;
+  vector<const Product<float> *> fltPrds;
+  for (const auto &id : productIds) {
+    const Product<double> *prd = getProduct<double>(id);
+    const Product<Number> *riskPrd = getProduct<Number>(id);
+    const Product<float> *fltPrd = getProduct<float>(id);
+    if (!prd || !riskPrd || !fltPrd) {
+      throw runtime_error("putPortfolio() : product not found: " + id);
+    }
+    prds.push_back(prd);
+    riskPrds.push_back(riskPrd);
+    fltPrds.push_back(fltPrd);
+  }
+
+  unique_ptr<Product<double>> prd = make_unique<PortfolioProduct<double>>(prds);
+  unique_ptr<Product<Number>> riskPrd =
+      make_unique<PortfolioProduct<Number>>(riskPrds);
+  unique_ptr<Product<float>> fltPrd =
+      make_unique<PortfolioProduct<float>>(fltPrds);
+
+  productStore[store] =
+      make_tuple(std::move(prd), std::move(riskPrd), std::move(fltPrd));
+}
+
+//  Dump the creation log into a compact binary snapshot
+void saveStore(const string &path) {
+  ofstream file(path, ios::binary);
+  if (!file)
+    throw runtime_error("saveStore() : cannot open " + path);
+
+  const auto &log = snapshotImpl::theLog();
+  string buf;
+  snapshotImpl::put(buf, string("MCSTORE1"));
+  snapshotImpl::put(buf, log.size());
+  for (const auto &record : log) {
+    snapshotImpl::put(buf, record.first);
+    snapshotImpl::put(buf, record.second);
+  }
+  file.write(buf.data(), buf.size());
+}
+
+//  Replay a snapshot, reconstituting the stores
+//  Existing entries with the same ids are overwritten,
+//      like repeated put* calls would
+void loadStore(const string &path) {
+  ifstream file(path, ios::binary);
+  if (!file)
+    throw runtime_error("loadStore() : cannot open " + path);
+  string buf((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+  size_t pos = 0;
+  string magic;
+  snapshotImpl::get(buf, pos, magic);
+  if (magic != "MCSTORE1")
+    throw runtime_error("loadStore() : not a store snapshot: " + path);
+
+  size_t count;
+  snapshotImpl::get(buf, pos, count);
+
+  //  Replaying: the put* calls must not re-log
+  snapshotImpl::replaying() = true;
+
+  try {
+    for (size_t r = 0; r < count; ++r) {
+      unsigned char tag;
+      string blob;
+      snapshotImpl::get(buf, pos, tag);
+      snapshotImpl::get(buf, pos, blob);
+      size_t p = 0;
+
+      using namespace snapshotImpl;
+      switch (tag) {
+      case tagBlackScholes: {
+        double spot, vol, rate, div;
+        bool qSpot;
+        string id;
+        get(blob, p, spot);
+        get(blob, p, vol);
+        get(blob, p, qSpot);
+        get(blob, p, rate);
+        get(blob, p, div);
+        get(blob, p, id);
+        putBlackScholes(spot, vol, qSpot, rate, div, id);
+        break;
+      }
+      case tagDupire: {
+        double spot, maxDt;
+        vector<double> spots;
+        vector<Time> times;
+        matrix<double> vols;
+        string id;
+        get(blob, p, spot);
+        get(blob, p, spots);
+        get(blob, p, times);
+        get(blob, p, vols);
+        get(blob, p, maxDt);
+        get(blob, p, id);
+        putDupire(spot, spots, times, vols, maxDt, id);
+        break;
+      }
+      case tagDisplaced: {
+        vector<string> assets;
+        vector<double> spots, atms, skews, repoSpreads;
+        double discRate, lambda;
+        vector<Time> divDates;
+        matrix<double> divs, correl;
+        string id;
+        get(blob, p, assets);
+        get(blob, p, spots);
+        get(blob, p, atms);
+        get(blob, p, skews);
+        get(blob, p, discRate);
+        get(blob, p, repoSpreads);
+        get(blob, p, divDates);
+        get(blob, p, divs);
+        get(blob, p, correl);
+        get(blob, p, lambda);
+        get(blob, p, id);
+        putDisplaced(assets, spots, atms, skews, discRate, repoSpreads,
+                     divDates, divs, correl, lambda, id);
+        break;
+      }
+      case tagEuropean: {
+        double strike;
+        Time exerciseDate, settlementDate;
+        string id;
+        get(blob, p, strike);
+        get(blob, p, exerciseDate);
+        get(blob, p, settlementDate);
+        get(blob, p, id);
+        putEuropean(strike, exerciseDate, settlementDate, id);
+        break;
+      }
+      case tagBarrier: {
+        double strike, barrier, monitorFreq, smooth;
+        Time maturity;
+        bool callPut;
+        string id;
+        get(blob, p, strike);
+        get(blob, p, barrier);
+        get(blob, p, maturity);
+        get(blob, p, monitorFreq);
+        get(blob, p, smooth);
+        get(blob, p, callPut);
+        get(blob, p, id);
+        putBarrier(strike, barrier, maturity, monitorFreq, smooth, callPut, id);
+        break;
+      }
+      case tagContingent: {
+        double coupon, payFreq, smooth;
+        Time maturity;
+        string id;
+        get(blob, p, coupon);
+        get(blob, p, maturity);
+        get(blob, p, payFreq);
+        get(blob, p, smooth);
+        get(blob, p, id);
+        putContingent(coupon, maturity, payFreq, smooth, id);
+        break;
+      }
+      case tagEuropeans: {
+        vector<Time> maturities;
+        vector<double> strikes;
+        string id;
+        get(blob, p, maturities);
+        get(blob, p, strikes);
+        get(blob, p, id);
+        putEuropeans(maturities, strikes, id);
+        break;
+      }
+      case tagMultiStats: {
+        vector<string> assets;
+        vector<Time> fixDates, fwdDates;
+        string id;
+        get(blob, p, assets);
+        get(blob, p, fixDates);
+        get(blob, p, fwdDates);
+        get(blob, p, id);
+        putMultiStats(assets, fixDates, fwdDates, id);
+        break;
+      }
+      case tagBaskets: {
+        vector<string> assets;
+        vector<double> weights, strikes;
+        Time maturity;
+        string id;
+        get(blob, p, assets);
+        get(blob, p, weights);
+        get(blob, p, maturity);
+        get(blob, p, strikes);
+        get(blob, p, id);
+        putBaskets(assets, weights, maturity, strikes, id);
+        break;
+      }
+      case tagAutocall: {
+        vector<string> assets;
+        vector<double> refs;
+        Time maturity;
+        int periods;
+        double ko, strike, cpn, smooth;
+        string id;
+        get(blob, p, assets);
+        get(blob, p, refs);
+        get(blob, p, maturity);
+        get(blob, p, periods);
+        get(blob, p, ko);
+        get(blob, p, strike);
+        get(blob, p, cpn);
+        get(blob, p, smooth);
+        get(blob, p, id);
+        putAutocall(assets, refs, maturity, periods, ko, strike, cpn, smooth,
+                    id);
+        break;
+      }
+      case tagPortfolio: {
+        vector<string> productIds;
+        string id;
+        get(blob, p, productIds);
+        get(blob, p, id);
+        putPortfolio(productIds, id);
+        break;
+      }
+      default:
+        throw runtime_error("loadStore() : unknown record in snapshot");
+      }
+
+      //  Keep the log in sync with the reconstituted store
+      snapshotImpl::theLog().push_back(make_pair(tag, blob));
+    }
+  } catch (...) {
+    snapshotImpl::replaying() = false;
+    throw;
+  }
+  snapshotImpl::replaying() = false;
 }
 
 const vector<string> *getPayoffLabels(const string &store) {
@@ -238,5 +746,5 @@ const vector<string> *getPayoffLabels(const string &store) {
   if (it == productStore.end())
     return nullptr;
   else
-    return &it->second.first.get()->payoffLabels();
+    return &get<0>(it->second).get()->payoffLabels();
 }
\ No newline at end of file